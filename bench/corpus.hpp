@@ -0,0 +1,316 @@
+//
+// Benchmark corpus.
+// Documents are generated deterministically, shaped after the usual
+// JSON benchmark files. Set SIJSON_BENCH_CORPUS to a directory with
+// twitter.json, canada.json and/or citm_catalog.json to use those instead.
+//
+
+#ifndef SIJSON_BENCH_CORPUS_HPP
+#define SIJSON_BENCH_CORPUS_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sijson/stringstream.hpp>
+#include <sijson/writer.hpp>
+
+namespace sijson {
+namespace bench {
+
+struct document
+{
+    std::string name;
+    std::string json;
+};
+
+// Small deterministic PRNG, so that documents are
+// the same on every platform.
+class rng
+{
+public:
+    rng(std::uint64_t seed) : m_state(seed) {}
+
+    inline std::uint64_t next(void)
+    {
+        m_state = m_state * 6364136223846793005u + 1442695040888963407u;
+        return m_state >> 16;
+    }
+
+    inline std::uint64_t below(std::uint64_t n) { return next() % n; }
+
+    inline double uniform(double lo, double hi) { return lo + (hi - lo) * (double)(next() % 1000000007u) / 1000000007.0; }
+
+    inline std::string word(std::size_t min_len, std::size_t max_len)
+    {
+        std::string s(min_len + below(max_len - min_len + 1), ' ');
+        for (auto& c : s)
+            c = (char)('a' + below(26));
+        return s;
+    }
+
+    inline std::string text(std::size_t num_words)
+    {
+        std::string s;
+        for (std::size_t i = 0; i < num_words; ++i)
+        {
+            if (i) s += ' ';
+            s += word(1, 10);
+        }
+        return s;
+    }
+
+private:
+    std::uint64_t m_state;
+};
+
+using writer = ascii_writer<ostdsstream>;
+
+// Social media API response: mixed objects, ints, short strings
+// with escapes and non-ASCII, bools and nulls.
+inline std::string make_twitter_like(void)
+{
+    rng r(1);
+    ostdsstream os;
+    writer w(os);
+
+    w.start_object();
+    w.write_key("statuses");
+    w.start_array();
+    for (int i = 0; i < 400; ++i)
+    {
+        std::uint64_t id = 505874924095815681u + r.below(1000000);
+        w.start_object();
+        w.write_key_value("created_at", "Sun Aug 31 00:29:15 +0000 2014");
+        w.write_key_value("id", id);
+        w.write_key_value("id_str", std::to_string(id));
+        w.write_key_value("text", "@" + r.word(4, 12) + " " + r.text(8) +
+            " \xe3\x81\x8a\xe3\x81\xaf\xe3\x82\x88\xe3\x81\x86 \"quoted\"\n#" + r.word(3, 8));
+        w.write_key_value("source", "<a href=\"http://twitter.com/download/iphone\" rel=\"nofollow\">Twitter for iPhone</a>");
+        w.write_key_value("truncated", false);
+        w.write_key_value("in_reply_to_status_id", nullptr);
+
+        w.write_key("user");
+        w.start_object();
+        w.write_key_value("id", r.below(3000000000u));
+        w.write_key_value("name", r.word(3, 10) + " " + r.word(3, 10));
+        w.write_key_value("screen_name", r.word(5, 15));
+        w.write_key_value("location", r.below(2) ? r.word(4, 10) : std::string());
+        w.write_key_value("description", r.text(12));
+        w.write_key_value("url", nullptr);
+        w.write_key_value("followers_count", r.below(100000));
+        w.write_key_value("friends_count", r.below(5000));
+        w.write_key_value("verified", r.below(10) == 0);
+        w.write_key_value("profile_image_url", "http://pbs.twimg.com/profile_images/" + std::to_string(r.next()) + "/normal.jpeg");
+        w.end_object();
+
+        w.write_key("entities");
+        w.start_object();
+        w.write_key("hashtags");
+        w.start_array();
+        for (std::uint64_t j = r.below(3); j > 0; --j)
+        {
+            w.start_object();
+            w.write_key_value("text", r.word(3, 12));
+            w.write_key("indices");
+            w.start_array();
+            w.write_value(r.below(140));
+            w.write_value(r.below(140));
+            w.end_array();
+            w.end_object();
+        }
+        w.end_array();
+        w.write_key("urls");
+        w.start_array();
+        w.end_array();
+        w.end_object();
+
+        w.write_key_value("retweet_count", r.below(1000));
+        w.write_key_value("favorited", false);
+        w.write_key_value("coordinates", nullptr);
+        w.write_key_value("lang", "ja");
+        w.end_object();
+    }
+    w.end_array();
+
+    w.write_key("search_metadata");
+    w.start_object();
+    w.write_key_value("completed_in", 0.087);
+    w.write_key_value("max_id", 505874924095815681u);
+    w.write_key_value("query", "%E4%B8%80");
+    w.write_key_value("count", 400);
+    w.end_object();
+    w.end_object();
+
+    return os.str();
+}
+
+// GeoJSON polygons: almost entirely floats with many digits.
+inline std::string make_canada_like(void)
+{
+    rng r(2);
+    ostdsstream os;
+    writer w(os);
+
+    w.start_object();
+    w.write_key_value("type", "FeatureCollection");
+    w.write_key("features");
+    w.start_array();
+    w.start_object();
+    w.write_key_value("type", "Feature");
+    w.write_key("properties");
+    w.start_object();
+    w.write_key_value("name", "Canada");
+    w.end_object();
+    w.write_key("geometry");
+    w.start_object();
+    w.write_key_value("type", "Polygon");
+    w.write_key("coordinates");
+    w.start_array();
+    for (int i = 0; i < 480; ++i)
+    {
+        double lon = r.uniform(-141, -52), lat = r.uniform(41, 83);
+        w.start_array();
+        for (int j = 0; j < 120; ++j)
+        {
+            lon += r.uniform(-0.01, 0.01);
+            lat += r.uniform(-0.01, 0.01);
+            w.start_array();
+            w.write_value(lon);
+            w.write_value(lat);
+            w.end_array();
+        }
+        w.end_array();
+    }
+    w.end_array();
+    w.end_object();
+    w.end_object();
+    w.end_array();
+    w.end_object();
+
+    return os.str();
+}
+
+// Event catalog: many keys, names and descriptions, id arrays.
+inline std::string make_citm_like(void)
+{
+    rng r(3);
+    ostdsstream os;
+    writer w(os);
+
+    w.start_object();
+    w.write_key("areaNames");
+    w.start_object();
+    for (int i = 0; i < 2000; ++i)
+        w.write_key_value(std::to_string(205705993 + i), r.text(3) + " \xc3\xa9tage");
+    w.end_object();
+
+    w.write_key("events");
+    w.start_object();
+    for (int i = 0; i < 1200; ++i)
+    {
+        std::uint64_t id = 138586341 + (std::uint64_t)i;
+        w.write_key(std::to_string(id));
+        w.start_object();
+        w.write_key_value("description", r.below(2) ? r.text(20) : std::string());
+        w.write_key_value("id", id);
+        w.write_key_value("logo", "/images/UE0AAAAACEKo6QAAAAZDSVRN" + r.word(4, 4));
+        w.write_key_value("name", r.text(4));
+        w.write_key("subTopicIds");
+        w.start_array();
+        for (std::uint64_t j = 1 + r.below(4); j > 0; --j)
+            w.write_value(337184269 + r.below(100));
+        w.end_array();
+        w.write_key_value("subjectCode", nullptr);
+        w.write_key_value("subtitle", nullptr);
+        w.write_key("topicIds");
+        w.start_array();
+        w.write_value(324846099);
+        w.write_value(107888604 + r.below(10));
+        w.end_array();
+        w.end_object();
+    }
+    w.end_object();
+
+    w.write_key("venueNames");
+    w.start_object();
+    for (int i = 0; i < 300; ++i)
+        w.write_key_value(r.word(6, 14) + "_" + r.word(6, 14), r.text(4));
+    w.end_object();
+    w.end_object();
+
+    return os.str();
+}
+
+// Arrays of deeply nested objects and arrays.
+inline std::string make_deep(void)
+{
+    rng r(4);
+    ostdsstream os;
+    writer w(os);
+
+    w.start_array();
+    for (int i = 0; i < 100; ++i)
+    {
+        const int depth = 500 + (int)r.below(1000);
+        for (int d = 0; d < depth; ++d)
+        {
+            if (d % 2)
+            {
+                w.start_array();
+                w.write_value(d);
+            }
+            else
+            {
+                w.start_object();
+                w.write_key("k");
+            }
+        }
+        w.write_value(true);
+        for (int d = depth - 1; d >= 0; --d)
+        {
+            if (d % 2) w.end_array();
+            else w.end_object();
+        }
+    }
+    w.end_array();
+
+    return os.str();
+}
+
+inline bool read_file(const std::string& path, std::string& out)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+
+    std::ostringstream ss;
+    ss << f.rdbuf();
+    out = ss.str();
+    return true;
+}
+
+inline std::vector<document> load_corpus(void)
+{
+    std::vector<document> docs = {
+        { "twitter", make_twitter_like() },
+        { "canada", make_canada_like() },
+        { "citm", make_citm_like() },
+        { "deep", make_deep() }
+    };
+
+    const char* dir = std::getenv("SIJSON_BENCH_CORPUS");
+    if (dir)
+    {
+        read_file(std::string(dir) + "/twitter.json", docs[0].json);
+        read_file(std::string(dir) + "/canada.json", docs[1].json);
+        read_file(std::string(dir) + "/citm_catalog.json", docs[2].json);
+    }
+    return docs;
+}
+
+}}
+
+#endif
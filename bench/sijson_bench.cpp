@@ -0,0 +1,359 @@
+//
+// Throughput of readers, writers and streams.
+// Results are in bytes of JSON per second.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <sijson/filestream.hpp>
+#include <sijson/memorystream.hpp>
+#include <sijson/reader.hpp>
+#include <sijson/stdstream.hpp>
+#include <sijson/stringstream.hpp>
+#include <sijson/writer.hpp>
+
+#include "corpus.hpp"
+
+using namespace sijson;
+
+namespace {
+
+enum event_t
+{
+    EVENT_start_object,
+    EVENT_end_object,
+    EVENT_start_array,
+    EVENT_end_array,
+    EVENT_key,
+    EVENT_string,
+    EVENT_number,
+    EVENT_bool,
+    EVENT_null
+};
+
+// Value read from a document, in document order.
+struct event
+{
+    event_t type;
+    std::string str;
+    number num;
+    bool boolean;
+};
+
+struct test_case
+{
+    std::string name;
+    std::string json;
+    std::vector<event> events;
+    // json saved to a file, for file streams
+    std::string path;
+    // size of the json written by ascii_writer
+    std::size_t written_size;
+};
+
+
+// Read any document with raw_ascii_reader.
+// If events is not null, appends the values read to it.
+template <typename Istream>
+std::size_t walk(raw_ascii_reader<Istream>& r, std::vector<event>* events)
+{
+    auto add = [&](event_t type) -> event* {
+        if (!events) return nullptr;
+        events->push_back(event{ type, std::string(), number(), false });
+        return &events->back();
+    };
+
+    std::size_t n = 0;
+    switch (r.token())
+    {
+        case TOKEN_begin_object:
+            r.read_start_object();
+            add(EVENT_start_object);
+            for (bool first = true; r.token() != TOKEN_end_object; first = false)
+            {
+                if (!first) r.read_item_separator();
+                auto key = r.read_string_view();
+                n += key.size();
+                if (auto e = add(EVENT_key)) e->str.assign(key.data(), key.size());
+                r.read_key_separator();
+                n += walk(r, events);
+            }
+            r.read_end_object();
+            add(EVENT_end_object);
+            break;
+
+        case TOKEN_begin_array:
+            r.read_start_array();
+            add(EVENT_start_array);
+            for (bool first = true; r.token() != TOKEN_end_array; first = false)
+            {
+                if (!first) r.read_item_separator();
+                n += walk(r, events);
+            }
+            r.read_end_array();
+            add(EVENT_end_array);
+            break;
+
+        case TOKEN_string:
+        {
+            auto str = r.read_string_view();
+            n += str.size();
+            if (auto e = add(EVENT_string)) e->str.assign(str.data(), str.size());
+            break;
+        }
+        case TOKEN_number:
+        {
+            number num = r.read_number();
+            n += num.type();
+            if (auto e = add(EVENT_number)) e->num = num;
+            break;
+        }
+        case TOKEN_boolean:
+        {
+            bool b = r.read_bool();
+            n += b;
+            if (auto e = add(EVENT_bool)) e->boolean = b;
+            break;
+        }
+        case TOKEN_null:
+            r.read_null();
+            add(EVENT_null);
+            break;
+
+        default:
+            throw std::runtime_error("Unexpected token.");
+    }
+    return n;
+}
+
+template <typename Istream>
+std::size_t read_document(raw_ascii_reader<Istream>& r, const test_case&)
+{
+    return walk(r, nullptr);
+}
+
+// ascii_reader reads separators implicitly, so it cannot look
+// ahead at the type of the next value. Instead, it reads the
+// document in the layout found by raw_ascii_reader, like a
+// program reading a known schema.
+template <typename Istream>
+std::size_t read_document(ascii_reader<Istream>& r, const test_case& tc)
+{
+    std::size_t n = 0;
+    for (auto& e : tc.events)
+    {
+        switch (e.type)
+        {
+            case EVENT_start_object: r.start_object(); break;
+            case EVENT_end_object: r.end_object(); break;
+            case EVENT_start_array: r.start_array(); break;
+            case EVENT_end_array: r.end_array(); break;
+            case EVENT_key: n += r.read_key_view().size(); break;
+            case EVENT_string: n += r.read_string_view().size(); break;
+            case EVENT_number: n += r.template read_value<number>().type(); break;
+            case EVENT_bool: n += r.template read_value<bool>(); break;
+            case EVENT_null: r.template read_value<std::nullptr_t>(); break;
+        }
+    }
+    return n;
+}
+
+template <typename Writer>
+void write_document(Writer& w, const test_case& tc)
+{
+    for (auto& e : tc.events)
+    {
+        switch (e.type)
+        {
+            case EVENT_start_object: w.start_object(); break;
+            case EVENT_end_object: w.end_object(); break;
+            case EVENT_start_array: w.start_array(); break;
+            case EVENT_end_array: w.end_array(); break;
+            case EVENT_key: w.write_key(e.str); break;
+            case EVENT_string: w.write_value(e.str); break;
+            case EVENT_number: w.write_value(e.num); break;
+            case EVENT_bool: w.write_value(e.boolean); break;
+            case EVENT_null: w.write_value(nullptr); break;
+        }
+    }
+}
+
+
+// Streams are created once per benchmark by the source/sink
+// constructor. reset() is called before each iteration.
+
+struct imstream_source
+{
+    using stream_type = imstream;
+    imstream is;
+
+    imstream_source(const test_case& tc) : is(tc.json.data(), tc.json.size()) {}
+    void reset(void) { is.rewind(); }
+    imstream& stream(void) { return is; }
+};
+
+template <fileio_mode_t Mode>
+struct ifilestream_source
+{
+    using stream_type = ifilestream;
+    const test_case& tc;
+    std::unique_ptr<ifilestream> is;
+
+    ifilestream_source(const test_case& tc) : tc(tc) {}
+    // reopen, since opening is part of reading a file
+    void reset(void) { is.reset(new ifilestream(tc.path.c_str(), internal::file::DEFAULT_BUFSIZE, Mode)); }
+    ifilestream& stream(void) { return *is; }
+};
+
+struct std_istream_source
+{
+    using stream_type = std_istream_wrapper<std::istringstream>;
+    std::istringstream ss;
+    stream_type is;
+
+    std_istream_source(const test_case& tc) : ss(tc.json), is(ss) {}
+    void reset(void) { is.rewind(); }
+    stream_type& stream(void) { return is; }
+};
+
+struct osstream_sink
+{
+    using stream_type = osstream;
+    const test_case& tc;
+    std::unique_ptr<osstream> os;
+
+    osstream_sink(const test_case& tc) : tc(tc) {}
+    void reset(void) { os.reset(new osstream()); }
+    osstream& stream(void) { return *os; }
+};
+
+template <fileio_mode_t Mode>
+struct ofilestream_sink
+{
+    using stream_type = ofilestream;
+    const test_case& tc;
+    std::unique_ptr<ofilestream> os;
+
+    ofilestream_sink(const test_case& tc) : tc(tc) {}
+    void reset(void)
+    {
+        os.reset(); // close previous file first
+        os.reset(new ofilestream((tc.path + ".out").c_str(), internal::file::DEFAULT_BUFSIZE, Mode));
+    }
+    ofilestream& stream(void) { return *os; }
+};
+
+
+template <typename Reader, typename Source>
+void register_parse(const std::string& name, const test_case& tc)
+{
+    benchmark::RegisterBenchmark(("parse/" + name + "/" + tc.name).c_str(),
+        [&tc](benchmark::State& state)
+        {
+            Source src(tc);
+            for (auto _ : state)
+            {
+                src.reset();
+                Reader r(src.stream());
+                benchmark::DoNotOptimize(read_document(r, tc));
+            }
+            state.SetBytesProcessed((std::int64_t)(state.iterations() * tc.json.size()));
+        });
+}
+
+template <typename Source>
+void register_parse_all(const std::string& source_name, const test_case& tc)
+{
+    using stream_type = typename Source::stream_type;
+    register_parse<raw_ascii_reader<stream_type>, Source>("raw_ascii_reader/" + source_name, tc);
+    register_parse<ascii_reader<stream_type>, Source>("ascii_reader/" + source_name, tc);
+}
+
+template <typename Sink>
+void register_write(const std::string& sink_name, const test_case& tc)
+{
+    benchmark::RegisterBenchmark(("write/ascii_writer/" + sink_name + "/" + tc.name).c_str(),
+        [&tc](benchmark::State& state)
+        {
+            Sink sink(tc);
+            for (auto _ : state)
+            {
+                sink.reset();
+                ascii_writer<typename Sink::stream_type> w(sink.stream());
+                write_document(w, tc);
+                sink.stream().flush();
+                benchmark::DoNotOptimize(sink.stream().outpos());
+            }
+            state.SetBytesProcessed((std::int64_t)(state.iterations() * tc.written_size));
+        });
+}
+
+test_case make_test_case(bench::document&& doc)
+{
+    test_case tc;
+    tc.name = std::move(doc.name);
+    tc.json = std::move(doc.json);
+
+    imstream is(tc.json.data(), tc.json.size());
+    raw_ascii_reader<imstream> r(is);
+    walk(r, &tc.events);
+
+    tc.path = "sijson_bench_" + tc.name + ".json";
+    ofilestream fs(tc.path.c_str());
+    fs.putn(tc.json.data(), tc.json.size());
+    fs.close();
+
+    osstream os;
+    ascii_writer<osstream> w(os);
+    write_document(w, tc);
+    tc.written_size = os.outpos();
+
+    return tc;
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    // test cases are referenced by the benchmarks
+    std::vector<test_case> cases;
+    for (auto& doc : bench::load_corpus())
+        cases.push_back(make_test_case(std::move(doc)));
+
+    for (auto& tc : cases)
+    {
+        register_parse_all<imstream_source>("imstream", tc);
+        register_parse_all<ifilestream_source<FILEIO_sync>>("ifilestream", tc);
+        register_parse_all<ifilestream_source<FILEIO_async>>("ifilestream_async", tc);
+        register_parse_all<std_istream_source>("std_istream_wrapper", tc);
+
+        register_write<osstream_sink>("osstream", tc);
+        register_write<ofilestream_sink<FILEIO_sync>>("ofilestream", tc);
+        register_write<ofilestream_sink<FILEIO_async>>("ofilestream_async", tc);
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    for (auto& tc : cases)
+    {
+        std::remove(tc.path.c_str());
+        std::remove((tc.path + ".out").c_str());
+    }
+    return 0;
+}
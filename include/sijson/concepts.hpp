@@ -37,6 +37,22 @@ struct is_istream<T, iutil::void_t<
     iutil::require_same_t<decltype(std::declval<T>().end()), bool>>> : std::true_type
 {};
 
+//
+// is_iwindowed<T>::value is true if T is an input stream that exposes
+// its buffered input, i.e. it implements:
+// - memspan<const char> window();
+// --- A span of the chars that can be extracted from inpos() without
+// --- further reads from the source. Empty only if end(). May refill
+// --- an internal buffer. The span is invalidated by any call other
+// --- than peek() or window().
+// - advance(std::size_t count);
+// --- Extract count chars. count must not be larger than window().size().
+//
+// Readers use this to consume runs of chars at once.
+//
+template <typename T>
+struct is_iwindowed : iutil::has_input_window<T> {};
+
 template <typename, typename = void>
 struct is_ostream : std::false_type {};
 
@@ -95,6 +111,28 @@ struct is_odata_spannable<T, iutil::void_t<
     iutil::require_same_t<decltype(std::declval<const T>().outdata()), memspan<const char>>>> : std::true_type
 {};
 
+template <typename, typename = void>
+struct is_oreservable : std::false_type {};
+
+//
+// is_oreservable<T>::value is true if T implements:
+// - char* reserve(std::size_t count);
+// --- Get a pointer to space for at least count chars at outpos().
+// --- The chars are not output until commit() is called. The pointer is
+// --- invalidated by any call other than commit().
+// - commit(std::size_t count);
+// --- Output the first count chars written to the space from the last
+// --- call to reserve(). count must not exceed the reserved count.
+//
+// This allows chars to be written directly into a stream's buffer,
+// with one capacity check for several chars.
+//
+template <typename T>
+struct is_oreservable<T, iutil::void_t<
+    iutil::require_same_t<decltype(std::declval<T>().reserve(std::declval<std::size_t>())), char*>,
+    decltype(std::declval<T>().commit(std::declval<std::size_t>()))>> : std::true_type
+{};
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,560 @@
+
+#ifndef SIJSON_DOCUMENT_HPP
+#define SIJSON_DOCUMENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+
+#include "internal/util.hpp"
+#include "internal/buffers.hpp"
+
+#include "common.hpp"
+#include "number.hpp"
+#include "reader.hpp"
+
+namespace sijson {
+
+struct member;
+
+// Immutable JSON value in a document.
+// Strings, arrays and objects reference memory
+// owned by the document, and are invalidated when
+// the document is cleared, re-parsed or destroyed.
+class value final
+{
+public:
+    enum type_t : std::uint32_t
+    {
+        TYPE_null,
+        TYPE_bool,
+        TYPE_intmax_t,
+        TYPE_uintmax_t,
+        TYPE_double,
+        TYPE_string,
+        TYPE_array,
+        TYPE_object
+    };
+
+public:
+    value(void) noexcept : m_uintg(0), m_size(0), m_type(TYPE_null) {}
+
+    value(value&&) noexcept = default;
+    value(const value&) noexcept = default;
+
+    value& operator=(value&&) noexcept = default;
+    value& operator=(const value&) noexcept = default;
+
+    // Get type.
+    inline type_t type(void) const noexcept { return m_type; }
+
+    inline bool is_null(void) const noexcept { return m_type == TYPE_null; }
+    inline bool is_bool(void) const noexcept { return m_type == TYPE_bool; }
+    inline bool is_string(void) const noexcept { return m_type == TYPE_string; }
+    inline bool is_array(void) const noexcept { return m_type == TYPE_array; }
+    inline bool is_object(void) const noexcept { return m_type == TYPE_object; }
+    inline bool is_number(void) const noexcept
+    {
+        return m_type == TYPE_intmax_t || m_type == TYPE_uintmax_t || m_type == TYPE_double;
+    }
+
+    // Get bool.
+    // Throws if value is not a bool.
+    inline bool get_bool(void) const
+    {
+        assert_type(TYPE_bool, "bool");
+        return m_bool;
+    }
+
+    // Get number.
+    // Throws if value is not a number.
+    inline number get_number(void) const
+    {
+        switch (m_type)
+        {
+            case TYPE_intmax_t: return m_intg;
+            case TYPE_uintmax_t: return m_uintg;
+            case TYPE_double: return m_dbl;
+            default: throw std::logic_error("Value is not a number");
+        }
+    }
+
+    // Get string (null-terminated). String is unescaped.
+    // Throws if value is not a string.
+    inline const char* get_string(void) const
+    {
+        assert_type(TYPE_string, "string");
+        return m_str;
+    }
+
+    // Get string length, number of array elements,
+    // or number of object members. 0 for other types.
+    inline std::size_t size(void) const noexcept
+    {
+        return m_size;
+    }
+
+    // Get array elements.
+    // Throws if value is not an array.
+    inline const value* begin(void) const
+    {
+        assert_type(TYPE_array, "array");
+        return m_elems;
+    }
+
+    // Get array elements.
+    // Throws if value is not an array.
+    inline const value* end(void) const
+    {
+        assert_type(TYPE_array, "array");
+        return m_elems + m_size;
+    }
+
+    // Get array element.
+    // Behavior is undefined if value is not an array
+    // or if index is out of range.
+    inline const value& operator[](std::size_t index) const noexcept
+    {
+        assert(m_type == TYPE_array && index < m_size);
+        return m_elems[index];
+    }
+
+    // Get array element.
+    // Throws if value is not an array or if index is out of range.
+    inline const value& at(std::size_t index) const
+    {
+        assert_type(TYPE_array, "array");
+        if (index >= m_size)
+            throw std::out_of_range("Array index out of range");
+        return m_elems[index];
+    }
+
+    // Get object members.
+    // Throws if value is not an object.
+    inline const member* member_begin(void) const
+    {
+        assert_type(TYPE_object, "object");
+        return m_members;
+    }
+
+    // Get object members.
+    // Throws if value is not an object.
+    inline const member* member_end(void) const;
+
+    // Find object member value by key.
+    // Returns nullptr if not found.
+    // Throws if value is not an object.
+    inline const value* find(const char* key, std::size_t length) const;
+
+    // Find object member value by key.
+    // Returns nullptr if not found.
+    // Throws if value is not an object.
+    inline const value* find(const char* key) const
+    {
+        return find(key, std::strlen(key));
+    }
+
+    // Get object member value by key.
+    // Throws if value is not an object or if key is not found.
+    inline const value& at(const char* key) const
+    {
+        const value* valp = find(key);
+        if (!valp)
+            throw std::out_of_range(std::string("Key not found: ") + key);
+        return *valp;
+    }
+
+private:
+    template <typename> friend class basic_document;
+
+    inline void assert_type(type_t type, const char* type_label) const
+    {
+        if (m_type != type)
+            throw std::logic_error(std::string("Value is not ") +
+                (type == TYPE_array || type == TYPE_object ? "an " : "a ") + type_label);
+    }
+
+    static inline std::uint32_t checked_size(std::size_t size)
+    {
+        if (size > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error("String, array or object is too large.");
+        return (std::uint32_t)size;
+    }
+
+    static inline value make_bool(bool b) noexcept
+    {
+        value v; v.m_type = TYPE_bool; v.m_bool = b;
+        return v;
+    }
+    static inline value make_number(const number& n) noexcept
+    {
+        value v;
+        switch (n.type())
+        {
+            case number::TYPE_intmax_t:
+                v.m_type = TYPE_intmax_t; v.m_intg = n.get_nothrow<std::intmax_t>(); break;
+            case number::TYPE_uintmax_t:
+                v.m_type = TYPE_uintmax_t; v.m_uintg = n.get_nothrow<std::uintmax_t>(); break;
+            default:
+                v.m_type = TYPE_double; v.m_dbl = n.as<double>(); break;
+        }
+        return v;
+    }
+    static inline value make_string(const char* str, std::size_t length)
+    {
+        value v; v.m_type = TYPE_string; v.m_str = str;
+        v.m_size = checked_size(length);
+        return v;
+    }
+    static inline value make_array(const value* elems, std::size_t size)
+    {
+        value v; v.m_type = TYPE_array; v.m_elems = elems;
+        v.m_size = checked_size(size);
+        return v;
+    }
+    static inline value make_object(const member* members, std::size_t size)
+    {
+        value v; v.m_type = TYPE_object; v.m_members = members;
+        v.m_size = checked_size(size);
+        return v;
+    }
+
+private:
+    union
+    {
+        bool m_bool;
+        std::intmax_t m_intg;
+        std::uintmax_t m_uintg;
+        double m_dbl;
+        const char* m_str;
+        const value* m_elems;
+        const member* m_members;
+    };
+    std::uint32_t m_size;
+    type_t m_type;
+};
+
+static_assert(sizeof(value) == 16, "Unexpected value size.");
+
+// Object member.
+struct member
+{
+    sijson::value key; // always a string
+    sijson::value value;
+};
+
+inline const member* value::member_end(void) const
+{
+    assert_type(TYPE_object, "object");
+    return m_members + m_size;
+}
+
+inline const value* value::find(const char* key, std::size_t length) const
+{
+    assert_type(TYPE_object, "object");
+    for (std::size_t i = 0; i < m_size; ++i)
+    {
+        const value& k = m_members[i].key;
+        if (k.m_size == length && std::memcmp(k.m_str, key, length) == 0)
+            return &m_members[i].value;
+    }
+    return nullptr;
+}
+
+
+namespace internal
+{
+// Output stream that builds a null-terminated
+// string in the free space of an arena.
+template <typename Allocator>
+class arena_strbuilder
+{
+public:
+    arena_strbuilder(arena<Allocator>& arena) :
+        m_arena(arena), m_len(0)
+    {}
+
+    inline void put(char c)
+    {
+        reserve(1);
+        m_arena.top()[m_len++] = c;
+    }
+
+    inline void put(char c, std::size_t count)
+    {
+        reserve(count);
+        std::memset(m_arena.top() + m_len, c, count);
+        m_len += count;
+    }
+
+    inline void putn(const char* str, std::size_t count)
+    {
+        reserve(count);
+        std::memcpy(m_arena.top() + m_len, str, count);
+        m_len += count;
+    }
+
+    inline void flush(void) {}
+
+    inline std::size_t outpos(void) const noexcept { return m_len; }
+
+    // Null-terminate and allocate the string.
+    inline memspan<const char> finish(void)
+    {
+        put('\0');
+        char* str = m_arena.top();
+        m_arena.commit(m_len);
+        return { str, str + m_len - 1 };
+    }
+
+private:
+    inline void reserve(std::size_t count)
+    {
+        if (m_arena.available() - m_len < count)
+            m_arena.reserve(m_len, m_len + std::max(count, m_len));
+    }
+
+private:
+    arena<Allocator>& m_arena;
+    std::size_t m_len;
+};
+}
+
+
+// JSON document object model.
+//
+// All strings, arrays and objects are stored in an arena. Parsing into
+// a document again reuses the memory of the previous parse, so a single
+// document should be kept around to parse many inputs of similar size.
+//
+template <
+    // Allocator type used for the arena and internal purposes/book-keeping.
+    typename AllocatorPolicy = std::allocator<void>>
+class basic_document
+{
+private:
+    using char_allocator = iutil::rebind_alloc_t<AllocatorPolicy, char>;
+    using arena_type = internal::arena<char_allocator>;
+    using stack_type = internal::buffer<value, iutil::rebind_alloc_t<AllocatorPolicy, value>>;
+
+public:
+    basic_document(const AllocatorPolicy& alloc = AllocatorPolicy()) :
+        m_arena(ARENA_BLOCKSIZE, char_allocator(alloc)),
+        m_stack(16, iutil::rebind_alloc_t<AllocatorPolicy, value>(alloc)),
+        m_stack_len(0)
+    {}
+
+    // rhs is left empty, and can be reused.
+    basic_document(basic_document&& rhs) :
+        m_arena(std::move(rhs.m_arena)),
+        m_stack(std::move(rhs.m_stack)),
+        m_stack_len(0),
+        m_root(rhs.m_root)
+    {
+        rhs.m_stack_len = 0;
+        rhs.m_root = value();
+    }
+
+    basic_document(const basic_document&) = delete;
+
+    basic_document& operator=(basic_document&&) = delete;
+    basic_document& operator=(const basic_document&) = delete;
+
+    // Parse a JSON value from an input stream, replacing the
+    // contents of the document. Stops after the value is read,
+    // so the stream may contain more data.
+    // If this function throws, the document is left empty.
+    template <typename Istream>
+    inline void parse(Istream& stream)
+    {
+        clear();
+        try {
+            raw_ascii_reader<Istream> rr(stream);
+            m_root = parse_value(rr);
+        }
+        catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    // Get root value. Null if the document is empty.
+    inline const value& root(void) const noexcept { return m_root; }
+
+    // Clear the document. Keeps memory for reuse.
+    inline void clear(void) noexcept
+    {
+        m_root = value();
+        m_stack_len = 0;
+        m_arena.reset();
+    }
+
+    // Clear the document and free all memory.
+    inline void release(void) noexcept
+    {
+        clear();
+        m_arena.release();
+    }
+
+private:
+    static constexpr std::size_t ARENA_BLOCKSIZE = 4096;
+
+    // No container is open.
+    static constexpr std::size_t NO_FRAME = (std::size_t)-1;
+
+    // Parse iteratively, so that deep nesting does not overflow the
+    // call stack. Each open array/object has a frame value on m_stack,
+    // followed by its children (keys and values, for objects). The
+    // frame holds the index of the parent frame.
+    template <typename Istream>
+    inline value parse_value(raw_ascii_reader<Istream>& rr)
+    {
+        // innermost open container
+        std::size_t frame = NO_FRAME;
+        value v;
+        while (true)
+        {
+            switch (rr.token())
+            {
+                case TOKEN_begin_object:
+                    rr.read_start_object();
+                    frame = push_frame(value::TYPE_object, frame);
+                    if (rr.token() != TOKEN_end_object) {
+                        parse_key(rr);
+                        continue; // read first value
+                    }
+                    v = close_frame(rr, frame);
+                    break;
+                case TOKEN_begin_array:
+                    rr.read_start_array();
+                    frame = push_frame(value::TYPE_array, frame);
+                    if (rr.token() != TOKEN_end_array)
+                        continue; // read first value
+                    v = close_frame(rr, frame);
+                    break;
+                case TOKEN_string: v = parse_string(rr); break;
+                case TOKEN_number: v = value::make_number(rr.read_number()); break;
+                case TOKEN_boolean: v = value::make_bool(rr.read_bool()); break;
+                case TOKEN_null: rr.read_null(); v = value(); break;
+                default: 
+                    throw iutil::parse_error_exp(rr.stream().inpos(), "value");
+            }
+
+            // add v to its container, and close
+            // the containers that end after it
+            while (true)
+            {
+                if (frame == NO_FRAME)
+                    return v;
+                push(v);
+
+                bool is_object = m_stack[frame].m_type == value::TYPE_object;
+                if (rr.token() != (is_object ? TOKEN_end_object : TOKEN_end_array))
+                {
+                    rr.read_item_separator();
+                    if (is_object)
+                        parse_key(rr);
+                    break; // read next value
+                }
+                v = close_frame(rr, frame);
+            }
+        }
+    }
+
+    template <typename Istream>
+    inline value parse_string(raw_ascii_reader<Istream>& rr)
+    {
+        internal::arena_strbuilder<char_allocator> os(m_arena);
+        rr.read_string(os);
+        auto str = os.finish();
+        return value::make_string(str.begin, str.size());
+    }
+
+    template <typename Istream>
+    inline void parse_key(raw_ascii_reader<Istream>& rr)
+    {
+        if (rr.token() != TOKEN_string)
+            throw iutil::parse_error_exp(rr.stream().inpos(), "key");
+        push(parse_string(rr));
+        rr.read_key_separator();
+    }
+
+    // Push frame of a container. Returns its index.
+    inline std::size_t push_frame(value::type_t type, std::size_t parent)
+    {
+        value f;
+        f.m_type = type;
+        f.m_uintg = parent;
+        push(f);
+        return m_stack_len - 1;
+    }
+
+    // Read end of the container at frame, and pop it.
+    // frame is set to its parent.
+    template <typename Istream>
+    inline value close_frame(raw_ascii_reader<Istream>& rr, std::size_t& frame)
+    {
+        std::size_t index = frame;
+        frame = (std::size_t)m_stack[index].m_uintg;
+
+        return m_stack[index].m_type == value::TYPE_object ?
+            close_object(rr, index) : close_array(rr, index);
+    }
+
+    // Read end of array, and pop its frame and elements.
+    template <typename Istream>
+    inline value close_array(raw_ascii_reader<Istream>& rr, std::size_t frame)
+    {
+        rr.read_end_array();
+
+        std::size_t first = frame + 1;
+        std::size_t size = m_stack_len - first;
+        auto elems = (value*)m_arena.allocate(size * sizeof(value), alignof(value));
+        std::uninitialized_copy(m_stack.begin() + first, m_stack.begin() + m_stack_len, elems);
+
+        m_stack_len = frame;
+        return value::make_array(elems, size);
+    }
+
+    // Read end of object, and pop its frame and members.
+    template <typename Istream>
+    inline value close_object(raw_ascii_reader<Istream>& rr, std::size_t frame)
+    {
+        rr.read_end_object();
+
+        std::size_t first = frame + 1;
+        std::size_t size = (m_stack_len - first) / 2;
+        auto members = (member*)m_arena.allocate(size * sizeof(member), alignof(member));
+        for (std::size_t i = 0; i < size; ++i)
+            ::new (members + i) member{ m_stack[first + 2 * i], m_stack[first + 2 * i + 1] };
+
+        m_stack_len = frame;
+        return value::make_object(members, size);
+    }
+
+    inline void push(const value& v)
+    {
+        m_stack.reserve(m_stack_len + 1);
+        m_stack[m_stack_len++] = v;
+    }
+
+private:
+    arena_type m_arena;
+    // Values of arrays/objects being parsed.
+    stack_type m_stack;
+    std::size_t m_stack_len;
+    value m_root;
+};
+
+using document = basic_document<>;
+
+}
+
+#endif
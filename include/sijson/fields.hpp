@@ -0,0 +1,202 @@
+//
+// Struct binding: read and write structs as JSON objects.
+//
+
+#ifndef SIJSON_FIELDS_HPP
+#define SIJSON_FIELDS_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "internal/util.hpp"
+
+#include "common.hpp"
+
+
+// Declare the fields of struct T, so that it can be written with
+// write_fields() and read with read_fields(). Keys are the field names.
+// Must be used in the namespace of T (functions are found by ADL).
+// Supports up to 32 fields.
+//
+// eg.
+//   namespace app {
+//   struct point { int x; int y; };
+//   SIJSON_FIELDS(point, x, y)
+//   }
+#define SIJSON_FIELDS(T, ...) \
+    inline std::size_t sijson_field_index(const T*, const char* key, std::size_t length) noexcept \
+    { \
+        SIJSON_INTERNAL_FOR_EACH(SIJSON_INTERNAL_MATCH_FIELD, __VA_ARGS__) \
+        return ::sijson::internal::no_field; \
+    } \
+    template <typename Func> \
+    inline void sijson_visit_field(T& obj, std::size_t index, Func&& f) \
+    { \
+        switch (index) { SIJSON_INTERNAL_FOR_EACH(SIJSON_INTERNAL_VISIT_FIELD, __VA_ARGS__) } \
+    } \
+    template <typename Func> \
+    inline void sijson_for_each_field(const T& obj, Func&& f) \
+    { \
+        SIJSON_INTERNAL_FOR_EACH(SIJSON_INTERNAL_WRITE_FIELD, __VA_ARGS__) \
+    }
+
+// Length and first char are compared first, and are constants,
+// so the compiler turns the chain into a few integer compares.
+#define SIJSON_INTERNAL_MATCH_FIELD(i, field) \
+    if (length == sizeof(#field) - 1 && key[0] == #field[0] && \
+        std::memcmp(key, #field, sizeof(#field) - 1) == 0) return i;
+
+#define SIJSON_INTERNAL_VISIT_FIELD(i, field) case i: f(obj.field); break;
+
+#define SIJSON_INTERNAL_WRITE_FIELD(i, field) f(#field, sizeof(#field) - 1, obj.field);
+
+// MSVC passes __VA_ARGS__ as one argument without this.
+#define SIJSON_INTERNAL_EXPAND(x) x
+
+#define SIJSON_INTERNAL_NARGS(...) \
+    SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_NARGS_IMPL(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define SIJSON_INTERNAL_NARGS_IMPL(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+
+#define SIJSON_INTERNAL_CONCAT(a, b) SIJSON_INTERNAL_CONCAT_IMPL(a, b)
+#define SIJSON_INTERNAL_CONCAT_IMPL(a, b) a##b
+
+// Expands to M(0, f1) M(1, f2) ... for fields f1, f2, ...
+#define SIJSON_INTERNAL_FOR_EACH(M, ...) \
+    SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_CONCAT(SIJSON_INTERNAL_FE_, SIJSON_INTERNAL_NARGS(__VA_ARGS__))(M, 0, __VA_ARGS__))
+
+#define SIJSON_INTERNAL_FE_1(M, i, x) M(i, x)
+#define SIJSON_INTERNAL_FE_2(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_1(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_3(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_2(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_4(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_3(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_5(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_4(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_6(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_5(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_7(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_6(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_8(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_7(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_9(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_8(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_10(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_9(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_11(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_10(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_12(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_11(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_13(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_12(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_14(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_13(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_15(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_14(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_16(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_15(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_17(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_16(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_18(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_17(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_19(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_18(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_20(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_19(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_21(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_20(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_22(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_21(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_23(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_22(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_24(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_23(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_25(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_24(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_26(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_25(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_27(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_26(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_28(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_27(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_29(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_28(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_30(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_29(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_31(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_30(M, i + 1, __VA_ARGS__))
+#define SIJSON_INTERNAL_FE_32(M, i, x, ...) M(i, x) SIJSON_INTERNAL_EXPAND(SIJSON_INTERNAL_FE_31(M, i + 1, __VA_ARGS__))
+
+
+namespace sijson {
+namespace internal {
+
+// Returned by sijson_field_index() if there is no such field.
+static constexpr std::size_t no_field = (std::size_t)-1;
+
+template <typename T, typename = void>
+struct has_fields : std::false_type {};
+
+template <typename T>
+struct has_fields<T, iutil::void_t<decltype(sijson_field_index(
+    std::declval<const T*>(), std::declval<const char*>(), std::size_t()))>> : std::true_type
+{};
+
+template <typename Reader, typename T>
+inline void read_field(Reader& r, T& value, std::true_type);
+
+template <typename Reader, typename T>
+inline void read_field(Reader& r, T& value, std::false_type) { r.read_value(value); }
+
+template <typename Writer, typename T>
+inline void write_field(Writer& w, const T& value, std::true_type);
+
+template <typename Writer, typename T>
+inline void write_field(Writer& w, const T& value, std::false_type) { w.write_value(value); }
+
+template <typename Reader>
+struct field_reader
+{
+    Reader& r;
+
+    template <typename T>
+    inline void operator()(T& value) { read_field(r, value, has_fields<T>{}); }
+};
+
+template <typename Writer>
+struct field_writer
+{
+    Writer& w;
+
+    template <typename T>
+    inline void operator()(const char* key, std::size_t length, const T& value)
+    {
+        w.write_key(key, length);
+        write_field(w, value, has_fields<T>{});
+    }
+};
+
+}
+
+// Read an object into obj with ascii_reader.
+// T must be declared with SIJSON_FIELDS. Keys may be in any order.
+// Keys that are not fields are skipped, and fields that are not
+// in the object are left unchanged. Fields of types declared with
+// SIJSON_FIELDS are read from nested objects.
+// Keys are matched without being copied to a string.
+template <typename Reader, typename T>
+inline void read_fields(Reader& r, T& obj)
+{
+    static_assert(internal::has_fields<T>::value, "T is not declared with SIJSON_FIELDS.");
+
+    r.start_object();
+    while (r.token() != TOKEN_end_object)
+    {
+        string_view key = r.read_key_view();
+        std::size_t index = sijson_field_index(&obj, internal::string_view_data(key), key.size());
+
+        if (index == internal::no_field)
+            r.skip_value();
+        else sijson_visit_field(obj, index, internal::field_reader<Reader>{ r });
+    }
+    r.end_object();
+}
+
+// Write obj as an object with ascii_writer.
+// T must be declared with SIJSON_FIELDS. Fields are written in
+// declaration order. Fields of types declared with SIJSON_FIELDS
+// are written as nested objects.
+template <typename Writer, typename T>
+inline void write_fields(Writer& w, const T& obj)
+{
+    static_assert(internal::has_fields<T>::value, "T is not declared with SIJSON_FIELDS.");
+
+    w.start_object();
+    sijson_for_each_field(obj, internal::field_writer<Writer>{ w });
+    w.end_object();
+}
+
+namespace internal {
+
+template <typename Reader, typename T>
+inline void read_field(Reader& r, T& value, std::true_type) { read_fields(r, value); }
+
+template <typename Writer, typename T>
+inline void write_field(Writer& w, const T& value, std::true_type) { write_fields(w, value); }
+
+}
+}
+
+#endif
@@ -15,21 +15,33 @@
 #include "common.hpp"
 #include "internal/util.hpp"
 #include "internal/impl_file.hpp"
+#include "internal/impl_async_file.hpp"
 #include "internal/buffers.hpp"
 
 namespace sijson {
 
+// I/O mode of file streams.
+enum fileio_mode_t : unsigned
+{
+    // Read/write on the calling thread.
+    FILEIO_sync,
+    // Read ahead/write behind on a background thread, using
+    // a second buffer. I/O overlaps with parsing/serialization.
+    FILEIO_async
+};
+
 // Input file stream.
 class ifilestream
 {
 private:
-    ifilestream(internal::file&& file, std::size_t bufsize) :
+    ifilestream(internal::file&& file, std::size_t bufsize, fileio_mode_t mode) :
         m_file(std::move(file)),
         m_buf{ iutil::uround_up(bufsize, internal::file::SYS_BUFSIZE) },
         m_buf_cur(m_buf.begin()),
-        m_buf_last(m_buf.begin()),
+        m_buf_end(m_buf.begin()),
         m_buf_eof(false),
-        m_posn(0)
+        m_posn(0),
+        m_refills(0)
     {
         if (bufsize == 0)
             throw std::invalid_argument("Buffer size is 0");
@@ -39,23 +51,31 @@ private:
 
         // disable std buffer
         m_file.set_unbuffered();
+        m_file.advise_sequential();
+
+        if (mode == FILEIO_async)
+            m_async.reset(new internal::read_ahead_file(std::move(m_file), m_buf.capacity()));
 
         // set EOF
         refill_buf(); 
     }
 
 public:
+    // If mode is FILEIO_async, the next bufsize chars are
+    // read on a background thread while the current ones are parsed.
     ifilestream(const char filepath[],
-        std::size_t bufsize = internal::file::SYS_BUFSIZE
+        std::size_t bufsize = internal::file::DEFAULT_BUFSIZE,
+        fileio_mode_t mode = FILEIO_sync
     ) :
-        ifilestream({ filepath, "rb" }, bufsize)
+        ifilestream({ filepath, "rb" }, bufsize, mode)
     {}
 
 #ifdef _MSC_VER
     ifilestream(const wchar_t filepath[],
-        std::size_t bufsize = internal::file::SYS_BUFSIZE
+        std::size_t bufsize = internal::file::DEFAULT_BUFSIZE,
+        fileio_mode_t mode = FILEIO_sync
     ) :
-        ifilestream({ filepath, L"rb" }, bufsize)
+        ifilestream({ filepath, L"rb" }, bufsize, mode)
     {}
 #endif
 
@@ -71,26 +91,37 @@ public:
     // Extract character. If end(), behavior is undefined.
     inline char take(void)
     {
-        char c = *m_buf_cur;
+        char c = *m_buf_cur++;
+        m_posn++;
 
-        if (m_buf_cur < m_buf_last) {
-            m_buf_cur++; m_posn++;
-        }
-        else {
-            if (!m_buf_eof) m_posn++;
+        if (m_buf_cur == m_buf_end)
             refill_buf();
-        }
         return c;
     }
 
+    // Extract count characters. count must
+    // not be larger than window().size().
+    inline void advance(std::size_t count)
+    {
+        m_buf_cur += count;
+        m_posn += count;
+
+        if (m_buf_cur == m_buf_end)
+            refill_buf();
+    }
+
+    // Span of the buffered input from inpos().
+    // Empty only if end().
+    inline memspan<const char> window(void) const noexcept { return { m_buf_cur, m_buf_end }; }
+
     // Get position.
     inline std::size_t inpos(void) const noexcept { return m_posn; }
 
     // True if the last operation completed by reaching the end of the stream.
-    inline bool end(void) const noexcept
-    {
-        return m_buf_eof && m_buf_cur == m_buf_last;
-    }
+    inline bool end(void) const noexcept { return m_buf_cur == m_buf_end; }
+
+    // Number of times the buffer was filled from the file.
+    inline std::size_t num_refills(void) const noexcept { return m_refills; }
 
     // Jump to the beginning of the stream.
     inline void rewind(void)
@@ -99,7 +130,9 @@ public:
             m_buf_cur = m_buf.begin();
         else 
         {   // refilled buffer before
-            m_file.rewind();
+            if (m_async)
+                m_async->rewind();
+            else m_file.rewind();
             reset_buf();
             refill_buf();
         }
@@ -111,27 +144,39 @@ public:
     // the stream will no longer be usable.
     inline void close(void) 
     {
-        if (!m_file.close())
-            throw std::runtime_error(std::string("Could not close ") + m_file.path());
+        if (m_async)
+            m_async->stop();
+
+        if (!file().close())
+            throw std::runtime_error(std::string("Could not close ") + file().path());
     }
 
 private:
-    inline std::size_t buf_avail(void) const noexcept { return (std::size_t)(m_buf_last + 1 - m_buf_cur); }
     inline std::size_t buf_used(void) const noexcept { return (std::size_t)(m_buf_cur - m_buf.begin()); }
 
+    // In async mode, the file is owned by m_async.
+    inline internal::file& file(void) noexcept { return m_async ? m_async->get_file() : m_file; }
+
     // Throws on I/O failure.
     // Sets buf_eof if further refills are unnecessary.
     // Returns num bytes read.
     inline std::size_t refill_buf(void)
     {
         if (m_buf_eof) return 0;
+        m_refills++;
 
-        std::size_t nread = m_file.read(m_buf.begin(), m_buf.capacity());
-        if (m_file.error())
-            throw std::runtime_error(std::string("Could not read from ") + m_file.path());
+        std::size_t nread;
+        if (m_async)
+            nread = m_async->swap_read(m_buf);
+        else
+        {
+            nread = m_file.read(m_buf.begin(), m_buf.capacity());
+            if (m_file.error())
+                throw std::runtime_error(std::string("Could not read from ") + m_file.path());
+        }
 
-        m_buf_last = nread > 0 ? m_buf.begin() + nread - 1 : m_buf.begin();
         m_buf_cur = m_buf.begin();
+        m_buf_end = m_buf.begin() + nread;
 
         if (nread < m_buf.capacity()) 
             m_buf_eof = true;
@@ -142,7 +187,7 @@ private:
     inline void reset_buf(void)
     {
         m_buf_cur = m_buf.begin();
-        m_buf_last = m_buf.begin();
+        m_buf_end = m_buf.begin();
         m_buf_eof = false;
     }
 
@@ -150,9 +195,94 @@ private:
     internal::file m_file;
     internal::buffer<char> m_buf;
     char* m_buf_cur;
-    char* m_buf_last; // always >= m_buf_cur
+    // Buffer is refilled as soon as it is
+    // exhausted, so m_buf_cur == m_buf_end only at EOF.
+    char* m_buf_end;
     bool m_buf_eof;
     std::size_t m_posn;
+    std::size_t m_refills;
+    // Null in sync mode.
+    std::unique_ptr<internal::read_ahead_file> m_async;
+};
+
+// Input memory-mapped file stream.
+// The file is mapped read-only and read in place, without
+// copying into an intermediate buffer. The file must not be
+// modified or truncated while the stream is open.
+class immapstream
+{
+private:
+    immapstream(internal::mapped_file&& file) :
+        m_file(std::move(file)),
+        m_begin(m_file.data()),
+        m_cur(m_begin),
+        m_end(m_begin + m_file.size())
+    {
+        if (!m_file.is_open())
+            throw std::runtime_error(std::string("Could not open ") + m_file.path());
+    }
+
+public:
+    immapstream(const char filepath[]) :
+        immapstream(internal::mapped_file(filepath))
+    {}
+
+#ifdef _MSC_VER
+    immapstream(const wchar_t filepath[]) :
+        immapstream(internal::mapped_file(filepath))
+    {}
+#endif
+
+    immapstream(immapstream&&) = default;
+    immapstream(const immapstream&) = delete;
+
+    immapstream& operator=(immapstream&&) = default;
+    immapstream& operator=(const immapstream&) = delete;
+
+    // Get character. If end(), behavior is undefined.
+    inline char peek(void) const noexcept { return *m_cur; }
+
+    // Extract character. If end(), behavior is undefined.
+    inline char take(void) noexcept { return *m_cur++; }
+
+    // Extract count characters. If fewer than count
+    // characters remain, behavior is undefined.
+    inline void advance(std::size_t count) noexcept { m_cur += count; }
+
+    // Span of the remaining input i.e. from inpos() to inlength().
+    inline memspan<const char> window(void) const noexcept { return { m_cur, m_end }; }
+
+    // Get position.
+    inline std::size_t inpos(void) const noexcept { return (std::size_t)(m_cur - m_begin); }
+
+    // Get total number of chars available for input (i.e. the file size).
+    inline std::size_t inlength(void) const noexcept { return (std::size_t)(m_end - m_begin); }
+
+    // Span of the entire input data i.e. from position 0 to inlength().
+    // Span is invalidated when the stream is closed or destroyed.
+    inline memspan<const char> indata(void) const noexcept { return { m_begin, m_end }; }
+
+    // True if the last operation reached the end of the stream.
+    inline bool end(void) const noexcept { return m_cur == m_end; }
+
+    // Jump to the beginning of the stream.
+    inline void rewind(void) noexcept { m_cur = m_begin; }
+
+    // Unmap file. Throws on failure.
+    // Whether or not the operation succeeds,
+    // the stream will no longer be usable.
+    inline void close(void)
+    {
+        m_begin = m_cur = m_end = "";
+        if (!m_file.close())
+            throw std::runtime_error(std::string("Could not close ") + m_file.path());
+    }
+
+private:
+    internal::mapped_file m_file;
+    const char* m_begin;
+    const char* m_cur;
+    const char* m_end;
 };
 
 
@@ -160,7 +290,7 @@ private:
 class ofilestream
 {
 private:
-    ofilestream(internal::file&& file, std::size_t bufsize) :
+    ofilestream(internal::file&& file, std::size_t bufsize, fileio_mode_t mode) :
         m_file(std::move(file)),
         m_buf{ iutil::uround_up(bufsize, internal::file::SYS_BUFSIZE) },        
         m_buf_cur(m_buf.begin()),
@@ -174,20 +304,28 @@ private:
 
         // disable std buffer
         m_file.set_unbuffered();
+
+        if (mode == FILEIO_async)
+            m_async.reset(new internal::write_behind_file(std::move(m_file), m_buf.capacity()));
     }
 
 public:
+    // If mode is FILEIO_async, full buffers are written on a background
+    // thread while output continues into a second buffer. Write errors
+    // are then reported by the next flush() or close().
     ofilestream(const char filepath[],
-        std::size_t bufsize = internal::file::SYS_BUFSIZE
+        std::size_t bufsize = internal::file::DEFAULT_BUFSIZE,
+        fileio_mode_t mode = FILEIO_sync
     ) :
-        ofilestream({ filepath, "wb" }, bufsize)
+        ofilestream({ filepath, "wb" }, bufsize, mode)
     {}
 
 #ifdef _MSC_VER
     ofilestream(const wchar_t filepath[],
-        std::size_t bufsize = internal::file::SYS_BUFSIZE
+        std::size_t bufsize = internal::file::DEFAULT_BUFSIZE,
+        fileio_mode_t mode = FILEIO_sync
     ) :
-        ofilestream({ filepath, L"wb" }, bufsize)
+        ofilestream({ filepath, L"wb" }, bufsize, mode)
     {}
 #endif
 
@@ -230,14 +368,48 @@ public:
             m_buf_cur += count;
             m_posn += count;
         }
+        else if (m_async)
+        {
+            // copy, so that the write overlaps with further output
+            buffered_write(count, [&](std::size_t n) {
+                std::memcpy(m_buf_cur, str, n);
+                str += n;
+            });
+        }
         else bulk_write(str, count);
     }
 
+    // Get space for at least count chars at outpos().
+    // See is_oreservable.
+    inline char* reserve(std::size_t count)
+    {
+        if (count > buf_avail())
+        {
+            flush_buf();
+            if (count > m_buf.capacity())
+            {
+                m_buf.reserve(count);
+                m_buf_cur = m_buf.begin();
+            }
+        }
+        return m_buf_cur;
+    }
+
+    // Output count chars from the space returned by reserve().
+    inline void commit(std::size_t count) noexcept
+    {
+        m_buf_cur += count;
+        m_posn += count;
+    }
+
     // Synchronize with target.
     inline void flush(void)
     {
-        if (!flush_buf<false>() || !m_file.flush())
-            throw std::runtime_error(std::string("Could not sync with ") + m_file.path());
+        bool flushed = flush_buf<false>() &&
+            (m_async ? m_async->sync() : m_file.flush());
+
+        if (!flushed)
+            throw std::runtime_error(std::string("Could not sync with ") + file().path());
     }
 
     // Get position.
@@ -250,19 +422,26 @@ public:
     {
         // always close, even if flush fails
         bool flushed = flush_buf<false>();
-        bool closed = m_file.close();
+        if (m_async)
+            flushed = m_async->stop() && flushed;
+        bool closed = file().close();
 
         if (!flushed || !closed)
-            throw std::runtime_error(std::string("Could not close ") + m_file.path());
+            throw std::runtime_error(std::string("Could not close ") + file().path());
     }
 
     ~ofilestream(void) noexcept
     {
-        flush_buf<false>(); // ignore errors
+        // not closed or moved from
+        if (file().is_open())
+            flush_buf<false>(); // ignore errors
         // file flushes + closes in destructor
     }
 
 private:
+    // In async mode, the file is owned by m_async.
+    inline internal::file& file(void) noexcept { return m_async ? m_async->get_file() : m_file; }
+
     inline std::size_t buf_avail(void) const noexcept { return (std::size_t)(m_buf.end() - m_buf_cur); }
     inline std::size_t buf_pending(void) const noexcept { return (std::size_t)(m_buf_cur - m_buf.begin()); }
     
@@ -276,6 +455,13 @@ private:
     {       
         auto npending = buf_pending();
 
+        if (m_async)
+        {   // errors are reported by flush() or close()
+            m_async->swap_write(m_buf, npending);
+            m_buf_cur = m_buf.begin();
+            return true;
+        }
+
         auto nwrote = m_file.write(m_buf.begin(), npending);
         if (nwrote != npending)
         {
@@ -350,6 +536,8 @@ private:
     internal::buffer<char> m_buf;
     char* m_buf_cur;
     std::size_t m_posn;
+    // Null in sync mode.
+    std::unique_ptr<internal::write_behind_file> m_async;
 };
 
 }
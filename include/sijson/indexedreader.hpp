@@ -0,0 +1,285 @@
+
+#ifndef SIJSON_INDEXEDREADER_HPP
+#define SIJSON_INDEXEDREADER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <stdexcept>
+
+#include "internal/util.hpp"
+#include "internal/simd.hpp"
+#include "internal/impl_index.hpp"
+
+#include "common.hpp"
+#include "number.hpp"
+#include "reader.hpp"
+
+
+namespace sijson {
+
+// Low-level ASCII JSON reader for in-memory input
+// (e.g. imstream, isstream, istdsstream, immapstream).
+//
+// On construction, the positions of all structural chars, strings and
+// scalars in the remaining input are found in a single vectorized pass.
+// Reading then jumps between these positions instead of examining
+// every char. Has the same interface as raw_ascii_reader.
+//
+template <typename Istream,
+    // Allocator type used for internal purposes/book-keeping.
+    typename AllocatorPolicy = std::allocator<void>>
+class raw_indexed_reader
+{
+    static_assert(iutil::has_contiguous_input<Istream>::value,
+        "Istream must be an in-memory stream.");
+
+private:
+    using index_type = internal::structural_index<
+        iutil::rebind_alloc_t<AllocatorPolicy, std::uint32_t>>;
+
+public:
+    using stream_type = Istream;
+
+public:
+    raw_indexed_reader(Istream& stream,
+        const AllocatorPolicy& alloc = AllocatorPolicy()
+    ) :
+        m_rr(stream),
+        m_index(iutil::rebind_alloc_t<AllocatorPolicy, std::uint32_t>(alloc)),
+        m_pos(0)
+    {
+        auto data = stream.indata();
+        m_terminated = m_index.build(data.begin, data.begin + stream.inpos(), data.end);
+    }
+
+    // Get next unread token.
+    inline token_t token(void);
+
+    inline void read_start_object(void) { read_char('{'); }
+    inline void read_end_object(void) { read_char('}'); }
+    inline void read_start_array(void) { read_char('['); }
+    inline void read_end_array(void) { read_char(']'); }
+    inline void read_key_separator(void) { read_char(':'); }
+    inline void read_item_separator(void) { read_char(','); }
+
+    inline std::int_least32_t read_int32(void) { return read<std::int_least32_t>(); }
+    inline std::int_least64_t read_int64(void) { return read<std::int_least64_t>(); }
+    inline std::uint_least32_t read_uint32(void) { return read<std::uint_least32_t>(); }
+    inline std::uint_least64_t read_uint64(void) { return read<std::uint_least64_t>(); }
+
+    inline float read_float(void) { return read<float>(); }
+    inline double read_double(void) { return read<double>(); }
+
+    // Read numerical value.
+    inline number read_number(void) { return read<number>(); }
+
+    inline bool read_bool(void) { return read<bool>(); }
+
+    inline void read_null(void) { read<std::nullptr_t>(); }
+
+    // Read string. String is unescaped.
+    inline std::string read_string(void) { return read<std::string>(); }
+
+    // Read string with custom traits/allocator. String is unescaped.
+    template <
+        typename Traits,
+        typename Allocator = std::allocator<char>>
+        inline std::basic_string<char, Traits, Allocator> read_string(void)
+    {
+        seek_value();
+        auto value = m_rr.template read_string<Traits, Allocator>();
+        end_value();
+        return value;
+    }
+
+    // Read string of custom type.
+    // DestString must be a std::basic_string.
+    // String is unescaped.
+    template <typename DestString>
+    inline DestString read_string_as(void)
+    {
+        static_assert(iutil::is_instance_of_basic_string<DestString, char>::value,
+            "DestString is not a std::basic_string.");
+
+        return read_string<typename DestString::traits_type, typename DestString::allocator_type>();
+    }
+
+    // Read string without copying if possible. String is unescaped.
+    // See raw_ascii_reader::read_string_view().
+    inline string_view read_string_view(void)
+    {
+        seek_value();
+        auto str = m_rr.read_string_view();
+        end_value();
+        return str;
+    }
+
+    // Read string into output stream.
+    // String is unescaped.
+    template <typename Ostream>
+    inline void read_string(Ostream& os)
+    {
+        seek_value();
+        m_rr.read_string(os);
+        end_value();
+    }
+
+    // Read string into output stream, or read null.
+    // If token is string, calls get_os(), writes the string to it, and returns
+    // TOKEN_string. If token is null, reads it and returns TOKEN_null.
+    // String is unescaped.
+    template <typename Func>
+    inline token_t read_string_or_null(Func get_os)
+    {
+        seek_value();
+        token_t token = m_rr.read_string_or_null(get_os);
+        end_value();
+        return token;
+    }
+
+    // Skip value of any type, including objects and arrays.
+    // Only brackets are matched, so the value is not fully validated.
+    inline void skip_value(void);
+
+    // Read value of type T.
+    // Supports the same types as raw_ascii_reader::read().
+    template <typename T>
+    inline T read(void)
+    {
+        seek_value();
+        T value = m_rr.template read<T>();
+        end_value();
+        return value;
+    }
+
+    // Get stream.
+    // Stream position is the end of the last token read.
+    inline stream_type& stream(void) noexcept { return m_rr.stream(); }
+
+private:
+    // Position of next unread token, or end of input.
+    inline std::size_t next_pos(void) noexcept
+    {
+        return m_pos < m_index.size() ? m_index[m_pos] : stream().inlength();
+    }
+
+    // Move stream to the next token.
+    inline void seek_value(void)
+    {
+        stream().advance(next_pos() - stream().inpos());
+    }
+
+    // Check that only whitespace follows the value
+    // just read, then move to the next token.
+    inline void end_value(void)
+    {
+        if (m_pos < m_index.size())
+            m_pos++;
+
+        auto data = stream().indata();
+        const char* cur = data.begin + stream().inpos();
+        const char* next = data.begin + next_pos();
+        if (cur > next || internal::simd::find_non_ws(cur, next) != next)
+            throw iutil::parse_error(stream().inpos(), "unexpected character");
+    }
+
+    inline void read_char(char expected);
+
+private:
+    raw_ascii_reader<Istream> m_rr;
+    index_type m_index;
+    std::size_t m_pos;
+    // False if the last string is not terminated.
+    bool m_terminated;
+};
+
+
+template <typename Istream, typename AllocatorPolicy>
+inline token_t raw_indexed_reader<Istream, AllocatorPolicy>::token(void)
+{
+    if (m_pos == m_index.size())
+        return TOKEN_eof;
+
+    char c = stream().indata().begin[m_index[m_pos]];
+    switch (c)
+    {
+        case '{': return TOKEN_begin_object;
+        case '}': return TOKEN_end_object;
+        case '[': return TOKEN_begin_array;
+        case ']': return TOKEN_end_array;
+        case ':': return TOKEN_key_separator;
+        case ',': return TOKEN_item_separator;
+        case '"': return TOKEN_string;
+        case 't':
+        case 'f': return TOKEN_boolean;
+        case 'n': return TOKEN_null;
+        case '-': return TOKEN_number;
+        default:
+            if (iutil::is_digit(c))
+                return TOKEN_number;
+            break;
+    }
+    throw iutil::parse_error_exp(m_index[m_pos], "token");
+}
+
+template <typename Istream, typename AllocatorPolicy>
+inline void raw_indexed_reader<Istream, AllocatorPolicy>::skip_value(void)
+{
+    const char* data = stream().indata().begin;
+    switch (token())
+    {
+        case TOKEN_begin_object:
+        case TOKEN_begin_array:
+        {
+            std::size_t depth = 0;
+            for (; m_pos != m_index.size(); ++m_pos)
+            {
+                char c = data[m_index[m_pos]];
+                if (c == '{' || c == '[') depth++;
+                else if ((c == '}' || c == ']') && --depth == 0)
+                    break;
+            }
+            if (m_pos == m_index.size())
+                throw iutil::parse_error_exp(stream().inlength(), "value");
+
+            stream().advance(m_index[m_pos] + 1 - stream().inpos());
+            m_pos++;
+        }
+        break;
+
+        case TOKEN_string:
+            if (!m_terminated && m_pos + 1 == m_index.size())
+                throw iutil::parse_error_exp(next_pos(), "value");
+            m_pos++;
+            stream().advance(next_pos() - stream().inpos());
+            break;
+
+        case TOKEN_number:
+        case TOKEN_boolean:
+        case TOKEN_null:
+            m_pos++;
+            stream().advance(next_pos() - stream().inpos());
+            break;
+
+        default:
+            throw iutil::parse_error_exp(next_pos(), "value");
+    }
+}
+
+template <typename Istream, typename AllocatorPolicy>
+inline void raw_indexed_reader<Istream, AllocatorPolicy>::read_char(char expected)
+{
+    std::size_t pos = next_pos();
+    if (m_pos == m_index.size() || stream().indata().begin[pos] != expected)
+        throw iutil::parse_error_exp(pos, std::string("'") + expected + '\'');
+
+    stream().advance(pos + 1 - stream().inpos());
+    m_pos++;
+}
+
+}
+
+#endif
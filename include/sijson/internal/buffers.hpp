@@ -3,7 +3,11 @@
 #define SIJSON_INTERNAL_BUFFERS_HPP
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
 #include <limits>
+#include <new>
 #include <memory>
 #include <type_traits>
 #include <ios>
@@ -48,11 +52,13 @@ public:
         buffer(16, alloc)
     {}
 
+    // rhs is left empty, and grows again on reserve().
     buffer(buffer&& rhs) :
         base(rhs), m_size(rhs.m_size),
         m_bufp(rhs.m_bufp)
     {
         rhs.m_bufp = nullptr;
+        rhs.m_size = 0;
     }
 
     buffer(const buffer& rhs) :
@@ -100,6 +106,7 @@ public:
                 m_bufp = rhs.m_bufp;
                 rhs.m_bufp = nullptr;
                 m_size = rhs.m_size;
+                rhs.m_size = 0;
             }
             // else copy (see Allocator requirements)
             else copy_assign(rhs, this->alloc());
@@ -117,7 +124,19 @@ public:
             return;
 
         grow_and_copy(this->alloc(), rqd_cap, m_bufp, m_size);
-    }    
+    }
+
+    // Swap contents with rhs. Allocators must
+    // compare equal, unless they propagate on swap.
+    inline void swap(buffer& rhs) noexcept
+    {
+        using std::swap;
+        if (Altraits::propagate_on_container_swap::value)
+            swap(this->alloc(), rhs.alloc());
+
+        swap(m_bufp, rhs.m_bufp);
+        swap(m_size, rhs.m_size);
+    }
 
     inline T* begin(void) noexcept { return m_bufp; }
     inline T* end(void) noexcept { return m_bufp + m_size; }
@@ -156,7 +175,7 @@ private:
         iutil::exception_guard<T, Allocator> guard(alloc, bufp, new_cap);
 
         std::copy(src, src + len, bufp);
-        iutil::alloc_unchecked_delete(this->alloc(), m_bufp, m_size);
+        iutil::alloc_delete(this->alloc(), m_bufp, m_size);
 
         m_bufp = bufp;
         m_size = new_cap;
@@ -457,6 +476,148 @@ private:
 
 
 
+// Bump allocator for many small objects that are freed together.
+//
+// Memory is obtained from Allocator in blocks of geometrically increasing size.
+// Nothing is freed until reset() or destruction. reset() keeps only the largest
+// block, so an arena reused for similar workloads settles into one allocation.
+//
+template <typename Allocator = std::allocator<char>>
+class arena : iutil::alloc_aware_container<iutil::rebind_alloc_t<Allocator, std::max_align_t>>
+{
+private:
+    using unit = std::max_align_t;
+    using unit_allocator = iutil::rebind_alloc_t<Allocator, unit>;
+    using base = iutil::alloc_aware_container<unit_allocator>;
+
+    struct block_header
+    {
+        block_header* prev;
+        std::size_t size; // in units, including header
+    };
+
+    static constexpr std::size_t HEADER_UNITS = 
+        (sizeof(block_header) + sizeof(unit) - 1) / sizeof(unit);
+
+public:
+    arena(std::size_t init_block_size = 4096,
+        const Allocator& alloc = Allocator()
+    ) :
+        base(unit_allocator(alloc)),
+        m_head(nullptr), m_top(nullptr), m_limit(nullptr),
+        m_init_block_size(init_block_size)
+    {}
+
+    arena(arena&& rhs) noexcept :
+        base(std::move(rhs)),
+        m_head(rhs.m_head), m_top(rhs.m_top), m_limit(rhs.m_limit),
+        m_init_block_size(rhs.m_init_block_size)
+    {
+        rhs.m_head = nullptr;
+        rhs.m_top = rhs.m_limit = nullptr;
+    }
+
+    arena(const arena&) = delete;
+    arena& operator=(arena&&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    // Start of free space in the current block.
+    inline char* top(void) noexcept { return m_top; }
+
+    // Number of free bytes in the current block.
+    inline std::size_t available(void) const noexcept 
+    { 
+        return (std::size_t)(m_limit - m_top);
+    }
+
+    // Allocate size bytes. align must be a power of 2 
+    // no greater than alignof(std::max_align_t).
+    inline void* allocate(std::size_t size, std::size_t align)
+    {
+        assert(align <= alignof(unit) && (align & (align - 1)) == 0);
+
+        auto pad = (std::size_t)(-(std::uintptr_t)m_top & (align - 1));
+        if (available() < pad + size)
+        {
+            reserve(0, size);
+            pad = 0; // blocks are max-aligned
+        }
+        void* ptr = m_top + pad;
+        m_top += pad + size;
+        return ptr;
+    }
+
+    // Make at least size bytes available at top(). If a new block
+    // is required, the first keep bytes at top() are copied to it.
+    inline void reserve(std::size_t keep, std::size_t size)
+    {
+        assert(keep <= available());
+        if (available() >= size)
+            return;
+
+        std::size_t min_units = HEADER_UNITS + (size + sizeof(unit) - 1) / sizeof(unit);
+        std::size_t units = m_head ? 2 * m_head->size :
+            HEADER_UNITS + (m_init_block_size + sizeof(unit) - 1) / sizeof(unit);
+        units = std::max(units, min_units);
+
+        unit* blockp = iutil::alloc_new<unit>(this->alloc(), units);
+        auto header = ::new (blockp) block_header{ m_head, units };
+
+        char* data = (char*)(blockp + HEADER_UNITS);
+        if (keep != 0)
+            std::memcpy(data, m_top, keep);
+
+        m_head = header;
+        m_top = data;
+        m_limit = (char*)(blockp + units);
+    }
+
+    // Mark size bytes at top() as allocated.
+    inline void commit(std::size_t size) noexcept
+    {
+        assert(size <= available());
+        m_top += size;
+    }
+
+    // Free all allocations. Keeps the largest block for reuse.
+    inline void reset(void) noexcept
+    {
+        if (!m_head) return;
+
+        free_blocks(m_head->prev);
+        m_head->prev = nullptr;
+        m_top = (char*)((unit*)m_head + HEADER_UNITS);
+    }
+
+    // Free all allocations and blocks.
+    inline void release(void) noexcept
+    {
+        free_blocks(m_head);
+        m_head = nullptr;
+        m_top = m_limit = nullptr;
+    }
+
+    ~arena(void) { release(); }
+
+private:
+    inline void free_blocks(block_header* header) noexcept
+    {
+        while (header)
+        {
+            block_header* prev = header->prev;
+            iutil::alloc_unchecked_delete(this->alloc(), (unit*)header, header->size);
+            header = prev;
+        }
+    }
+
+private:
+    block_header* m_head; // current (and largest) block
+    char* m_top;
+    char* m_limit;
+    std::size_t m_init_block_size;
+};
+
+
 // Fixed-size array stream buffer (modeled after C++23's std::basic_spanbuf).
 template <typename CharT, typename Traits = std::char_traits<CharT>>
 class basic_memspanbuf : public std::basic_streambuf<CharT, Traits>
@@ -11,6 +11,10 @@
 
 #include "util.hpp"
 
+#ifdef SIJSON_HAS_STRING_VIEW
+#include <string_view>
+#endif
+
 namespace sijson {
 
 enum token_t : unsigned
@@ -25,7 +29,9 @@ enum token_t : unsigned
     TOKEN_number,
     TOKEN_string,
     TOKEN_boolean,
-    TOKEN_null
+    TOKEN_null,
+    // Number of token types.
+    NUM_TOKEN_TYPES
 };
 
 enum doc_node_t : unsigned
@@ -89,6 +95,34 @@ struct memspan
     // Always one past the last element.
     T* end;
 };
+
+// Read-only view of a string.
+#ifdef SIJSON_HAS_STRING_VIEW
+using string_view = std::string_view;
+#else
+using string_view = memspan<const char>;
+#endif
+
+namespace internal
+{
+inline string_view make_string_view(const char* begin, const char* end) noexcept
+{
+#ifdef SIJSON_HAS_STRING_VIEW
+    return { begin, (std::size_t)(end - begin) };
+#else
+    return { begin, end };
+#endif
+}
+
+inline const char* string_view_data(string_view str) noexcept
+{
+#ifdef SIJSON_HAS_STRING_VIEW
+    return str.data();
+#else
+    return str.begin;
+#endif
+}
+}
 }
 
 #endif
\ No newline at end of file
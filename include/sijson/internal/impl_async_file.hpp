@@ -0,0 +1,250 @@
+//
+// Background file I/O for file streams.
+//
+
+#ifndef SIJSON_INTERNAL_IMPL_ASYNC_FILE_HPP
+#define SIJSON_INTERNAL_IMPL_ASYNC_FILE_HPP
+
+#include <cstddef>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <stdexcept>
+
+#include "impl_file.hpp"
+#include "buffers.hpp"
+
+
+namespace sijson {
+namespace internal {
+
+// Reads a file on a background thread. While the
+// caller uses one buffer, the next is read into another.
+class read_ahead_file
+{
+public:
+    // Starts reading the first bufsize chars.
+    read_ahead_file(file&& f, std::size_t bufsize) :
+        m_file(std::move(f)),
+        m_buf(bufsize),
+        m_nread(0),
+        m_reading(true),
+        m_error(false),
+        m_stopped(false)
+    {
+        m_thread = std::thread([this] { run(); });
+    }
+
+    // thread refers to this
+    read_ahead_file(read_ahead_file&&) = delete;
+    read_ahead_file(const read_ahead_file&) = delete;
+
+    read_ahead_file& operator=(read_ahead_file&&) = delete;
+    read_ahead_file& operator=(const read_ahead_file&) = delete;
+
+    // Wait for the read in progress, swap its buffer with buf,
+    // then start reading into the old buffer.
+    // Returns the number of chars read into buf.
+    // Throws on I/O failure.
+    inline std::size_t swap_read(buffer<char>& buf)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&] { return !m_reading; });
+
+        if (m_error)
+            throw std::runtime_error(std::string("Could not read from ") + m_file.path());
+
+        buf.swap(m_buf);
+        std::size_t nread = m_nread;
+
+        // else EOF, no need to read further
+        if (nread == buf.capacity())
+        {
+            m_reading = true;
+            m_cv.notify_all();
+        }
+        return nread;
+    }
+
+    // Jump to the beginning of the file and
+    // start reading the first chars again.
+    inline void rewind(void)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&] { return !m_reading; });
+
+        m_file.rewind();
+        m_error = false;
+        m_reading = true;
+        m_cv.notify_all();
+    }
+
+    // Stop the background thread. After this,
+    // only get_file() may be used.
+    inline void stop(void) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    // Get file. Other than path(), the file
+    // may only be used after stop().
+    inline file& get_file(void) noexcept { return m_file; }
+
+    ~read_ahead_file(void) { stop(); }
+
+private:
+    inline void run(void)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_cv.wait(lock, [&] { return m_reading || m_stopped; });
+            if (m_stopped)
+                return;
+
+            // the caller does not touch m_buf or m_file while reading
+            lock.unlock();
+            std::size_t nread = m_file.read(m_buf.begin(), m_buf.capacity());
+            bool error = m_file.error() != 0;
+            lock.lock();
+
+            m_nread = nread;
+            m_error = error;
+            m_reading = false;
+            m_cv.notify_all();
+        }
+    }
+
+private:
+    file m_file;
+    buffer<char> m_buf;
+    std::size_t m_nread;
+    bool m_reading;
+    bool m_error;
+    bool m_stopped;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+};
+
+
+// Writes a file on a background thread. While one buffer
+// is being written, the caller fills another.
+class write_behind_file
+{
+public:
+    write_behind_file(file&& f, std::size_t bufsize) :
+        m_file(std::move(f)),
+        m_buf(bufsize),
+        m_count(0),
+        m_writing(false),
+        m_error(false),
+        m_stopped(false)
+    {
+        m_thread = std::thread([this] { run(); });
+    }
+
+    // thread refers to this
+    write_behind_file(write_behind_file&&) = delete;
+    write_behind_file(const write_behind_file&) = delete;
+
+    write_behind_file& operator=(write_behind_file&&) = delete;
+    write_behind_file& operator=(const write_behind_file&) = delete;
+
+    // Wait for the write in progress, swap its buffer with buf,
+    // then start writing the first count chars of the old buffer.
+    // Errors are reported by sync() or stop().
+    inline void swap_write(buffer<char>& buf, std::size_t count)
+    {
+        if (count == 0)
+            return;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&] { return !m_writing; });
+
+        buf.swap(m_buf);
+        m_count = count;
+        m_writing = true;
+        m_cv.notify_all();
+    }
+
+    // Wait for the write in progress, then flush the file.
+    // Returns false if this or any previous write failed.
+    inline bool sync(void)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&] { return !m_writing; });
+
+        if (!m_error && !m_file.flush())
+            m_error = true;
+        return !m_error;
+    }
+
+    // Finish the write in progress, then stop the background thread.
+    // Returns false if any write failed. After this, only get_file()
+    // may be used.
+    inline bool stop(void) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable())
+            m_thread.join();
+
+        return !m_error;
+    }
+
+    // Get file. Other than path(), the file
+    // may only be used after stop().
+    inline file& get_file(void) noexcept { return m_file; }
+
+    ~write_behind_file(void) { stop(); }
+
+private:
+    inline void run(void)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_cv.wait(lock, [&] { return m_writing || m_stopped; });
+            if (!m_writing)
+                return;
+
+            // the caller does not touch m_buf or m_file while writing
+            lock.unlock();
+            bool error = m_file.write(m_buf.begin(), m_count) != m_count;
+            lock.lock();
+
+            m_error = m_error || error;
+            m_writing = false;
+            m_cv.notify_all();
+        }
+    }
+
+private:
+    file m_file;
+    buffer<char> m_buf;
+    std::size_t m_count;
+    bool m_writing;
+    bool m_error; // sticky
+    bool m_stopped;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+};
+
+}}
+
+#endif
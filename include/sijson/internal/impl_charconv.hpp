@@ -0,0 +1,728 @@
+//
+// Conversions between numbers and decimal text.
+//
+
+#ifndef SIJSON_INTERNAL_IMPL_CHARCONV_HPP
+#define SIJSON_INTERNAL_IMPL_CHARCONV_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <ios>
+#include <istream>
+#include <locale>
+#include <type_traits>
+
+#include "util.hpp"
+#include "buffers.hpp"
+#include "impl_pow10.hpp"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#ifndef SIJSON_HAS_FROM_CHARS
+#if SIJSON_CPLUSPLUS >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#if defined(__cpp_lib_to_chars)
+#define SIJSON_HAS_FROM_CHARS
+#endif
+#endif
+#endif
+#endif
+
+#ifdef SIJSON_HAS_FROM_CHARS
+#include <charconv>
+#include <system_error>
+#endif
+
+
+namespace sijson {
+namespace internal {
+namespace charconv {
+
+struct uint128
+{
+    std::uint64_t hi;
+    std::uint64_t lo;
+};
+
+#if defined(__SIZEOF_INT128__)
+// __extension__ keeps -Wpedantic quiet.
+__extension__ typedef unsigned __int128 native_uint128;
+#endif
+
+// Full product of two 64-bit values.
+inline uint128 mul64(std::uint64_t a, std::uint64_t b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    auto p = (native_uint128)a * b;
+    return { (std::uint64_t)(p >> 64), (std::uint64_t)p };
+#elif defined(_MSC_VER) && defined(_M_X64)
+    std::uint64_t hi;
+    std::uint64_t lo = _umul128(a, b, &hi);
+    return { hi, lo };
+#else
+    std::uint64_t a_lo = (std::uint32_t)a, a_hi = a >> 32;
+    std::uint64_t b_lo = (std::uint32_t)b, b_hi = b >> 32;
+
+    std::uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi;
+    std::uint64_t hl = a_hi * b_lo, hh = a_hi * b_hi;
+
+    std::uint64_t mid = (ll >> 32) + (std::uint32_t)lh + (std::uint32_t)hl;
+    return { hh + (lh >> 32) + (hl >> 32) + (mid >> 32), (mid << 32) | (std::uint32_t)ll };
+#endif
+}
+
+// Number of leading zero bits. Value must be non-zero.
+inline int clz64(std::uint64_t value) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(value);
+#else
+    int n = 0;
+    while (!(value & 0x8000000000000000u)) {
+        value <<= 1; n++;
+    }
+    return n;
+#endif
+}
+
+
+// Load 8 chars as a little-endian integer.
+inline std::uint64_t load_le64(const char* p) noexcept
+{
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+// True if all 8 chars loaded with load_le64() are digits.
+inline bool is_eight_digits(std::uint64_t chars) noexcept
+{
+    return (((chars + 0x4646464646464646u) | (chars - 0x3030303030303030u)) &
+        0x8080808080808080u) == 0;
+}
+
+// Value of 8 digits loaded with load_le64(). SWAR multiply-add:
+// combine adjacent digits, then pairs, then quads.
+inline std::uint32_t parse_eight_digits(std::uint64_t chars) noexcept
+{
+    constexpr std::uint64_t mask = 0x000000ff000000ffu;
+    constexpr std::uint64_t mul1 = 100 + (1000000ull << 32);
+    constexpr std::uint64_t mul2 = 1 + (10000ull << 32);
+
+    chars -= 0x3030303030303030u;
+    chars = (chars * 10) + (chars >> 8);
+    chars = (((chars & mask) * mul1) + (((chars >> 16) & mask) * mul2)) >> 32;
+    return (std::uint32_t)chars;
+}
+
+// Parse an unsigned integer from the digits starting at first.
+// On success, first is set to the end of the digits.
+// Fails if there are no digits, if there are leading zeros
+// (as in JSON), or if the value overflows UintT.
+template <typename UintT>
+inline bool parse_uint(const char*& first, const char* last, UintT& out_value) noexcept
+{
+    static_assert(std::is_unsigned<UintT>::value && 
+        std::numeric_limits<UintT>::digits <= 64, "Unsupported type");
+
+    constexpr int max_digits = 19; // always fits in uint64
+
+    const char* p = first;
+    if (p != last && *p == '0')
+    {
+        p++;
+        if (p != last && util::is_digit(*p))
+            return false;
+    }
+
+    const char* digits_begin = p;
+    std::uint64_t value = 0;
+    while (last - p >= 8 && (p - digits_begin) + 8 <= max_digits)
+    {
+        std::uint64_t chars = load_le64(p);
+        if (!is_eight_digits(chars)) break;
+        value = value * 100000000u + parse_eight_digits(chars);
+        p += 8;
+    }
+    for (; p != last && util::is_digit(*p); ++p)
+    {
+        auto digit = (unsigned)(*p - '0');
+        if (p - digits_begin >= max_digits) {
+            if (p - digits_begin > max_digits || 
+                value > (std::numeric_limits<std::uint64_t>::max() - digit) / 10)
+                return false; // overflow
+        }
+        value = 10 * value + digit;
+    }
+    if (p == first || value > std::numeric_limits<UintT>::max())
+        return false;
+
+    out_value = (UintT)value;
+    first = p;
+    return true;
+}
+
+template <typename FloatT> struct ieee_traits {};
+
+template <> struct ieee_traits<double>
+{
+    using bits_type = std::uint64_t;
+    static constexpr int significand_bits = 52; // explicit bits
+    static constexpr int exponent_bias = 1023;
+    static constexpr int max_biased_exponent = 0x7FF;
+    // smallest/largest q such that w * 10^q may be finite and non-zero
+    static constexpr int min_exp10 = -342;
+    static constexpr int max_exp10 = 308;
+    // exactly representable powers of ten and significands
+    static constexpr int max_exact_exp10 = 22;
+    static constexpr std::uint64_t max_exact_significand = std::uint64_t(1) << 53;
+    // range of q in which ties-to-even may be ambiguous
+    static constexpr int min_exp10_round_to_even = -4;
+    static constexpr int max_exp10_round_to_even = 23;
+};
+
+template <> struct ieee_traits<float>
+{
+    using bits_type = std::uint32_t;
+    static constexpr int significand_bits = 23;
+    static constexpr int exponent_bias = 127;
+    static constexpr int max_biased_exponent = 0xFF;
+    static constexpr int min_exp10 = -65;
+    static constexpr int max_exp10 = 38;
+    static constexpr int max_exact_exp10 = 10;
+    static constexpr std::uint64_t max_exact_significand = std::uint64_t(1) << 24;
+    static constexpr int min_exp10_round_to_even = -17;
+    static constexpr int max_exp10_round_to_even = 10;
+};
+
+template <typename FloatT>
+inline FloatT exact_pow10(int e) noexcept
+{
+    static const FloatT table[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    return table[e];
+}
+
+// Significand (with its implicit bit) and biased exponent
+// of a binary floating-point value.
+struct binary_fp
+{
+    std::uint64_t significand;
+    int exponent;
+};
+
+// Eisel-Lemire algorithm. Computes the nearest binary value to w * 10^q.
+// Returns false if the result cannot be determined cheaply and a
+// slower algorithm must be used instead.
+// https://arxiv.org/abs/2101.11408
+template <typename FloatT>
+inline bool eisel_lemire(std::uint64_t w, int q, binary_fp& out) noexcept
+{
+    using traits = ieee_traits<FloatT>;
+    constexpr int mbits = traits::significand_bits;
+
+    if (w == 0 || q < traits::min_exp10) {
+        out = { 0, 0 };
+        return true;
+    }
+    if (q > traits::max_exp10) {
+        out = { 0, traits::max_biased_exponent };
+        return true;
+    }
+
+    int lz = clz64(w);
+    w <<= lz;
+
+    // table is truncated, except where the product
+    // needs an upper bound to detect ambiguity
+    const std::uint64_t* p10 = pow10::significand128(q);
+    std::uint64_t p10_lo = p10[1] + (q >= -27 && q < 0);
+    std::uint64_t p10_hi = p10[0] + (p10_lo < p10[1]);
+
+    constexpr std::uint64_t precision_mask = 0xFFFFFFFFFFFFFFFFu >> (mbits + 3);
+    uint128 product = mul64(w, p10_hi);
+    if ((product.hi & precision_mask) == precision_mask)
+    {
+        // need more precision
+        uint128 lower = mul64(w, p10_lo);
+        product.lo += lower.hi;
+        if (lower.hi > product.lo)
+            product.hi++;
+    }
+
+    // rare, product may still be off by one
+    // (the table is exact for q in [-27, 55])
+    if (product.lo == 0xFFFFFFFFFFFFFFFFu && (q < -27 || q > 55))
+        return false;
+
+    int upperbit = (int)(product.hi >> 63);
+    int shift = upperbit + 64 - mbits - 3;
+    std::uint64_t significand = product.hi >> shift;
+    // floor(log2(10^q)) + 63
+    int exponent = ((217706 * q) >> 16) + 63 + upperbit - lz + traits::exponent_bias;
+
+    if (exponent <= 0) // subnormal
+    {
+        if (-exponent + 1 >= 64) {
+            out = { 0, 0 };
+            return true;
+        }
+        significand >>= -exponent + 1;
+        significand += significand & 1; // round
+        significand >>= 1;
+        // may have rounded up to a normal value
+        exponent = significand < (std::uint64_t(1) << mbits) ? 0 : 1;
+        out = { significand, exponent };
+        return true;
+    }
+
+    // exactly halfway between two values, round to even
+    if (product.lo <= 1 &&
+        q >= traits::min_exp10_round_to_even && q <= traits::max_exp10_round_to_even &&
+        (significand & 3) == 1 && (significand << shift) == product.hi)
+    {
+        significand &= ~std::uint64_t(1);
+    }
+
+    significand += significand & 1; // round
+    significand >>= 1;
+    if (significand >= (std::uint64_t(2) << mbits))
+    {
+        significand = std::uint64_t(1) << mbits;
+        exponent++;
+    }
+
+    if (exponent >= traits::max_biased_exponent)
+        out = { 0, traits::max_biased_exponent };
+    else out = { significand, exponent };
+    return true;
+}
+
+template <typename FloatT>
+inline FloatT to_floating(binary_fp fp, bool neg) noexcept
+{
+    using traits = ieee_traits<FloatT>;
+    using bits_type = typename traits::bits_type;
+
+    auto bits = (bits_type)(fp.significand & ((std::uint64_t(1) << traits::significand_bits) - 1));
+    bits |= (bits_type)fp.exponent << traits::significand_bits;
+    bits |= (bits_type)neg << (sizeof(bits_type) * 8 - 1);
+
+    FloatT value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Fallback for values that cannot be converted by eisel_lemire().
+template <typename FloatT>
+inline bool parse_floating_slow(const char* begin, const char* end, FloatT& out_value)
+{
+#ifdef SIJSON_HAS_FROM_CHARS
+    auto result = std::from_chars(begin, end, out_value);
+    return result.ec == std::errc() && result.ptr == end;
+#else
+    bool neg = *begin == '-';
+    if (neg) begin++;
+
+    internal::memspanbuf streambuf(const_cast<char*>(begin),
+        (std::streamsize)(end - begin), std::ios_base::in);
+    std::istream sstream(&streambuf);
+    sstream.imbue(std::locale::classic()); // make decimal point '.'
+    sstream >> out_value;
+
+    if (neg)
+        out_value = -out_value;
+
+    return !sstream.fail();
+#endif
+}
+
+// Parse a JSON number as a floating-point value.
+// The entire range [begin, end) must be a number.
+// Returns false if the text is not a number or the
+// value is too large to be represented by FloatT.
+template <typename FloatT>
+inline bool parse_floating(const char* begin, const char* end, FloatT& out_value)
+{
+    using traits = ieee_traits<FloatT>;
+    constexpr int max_digits = 19; // always fits in uint64
+
+    const char* p = begin;
+    bool neg = p != end && *p == '-';
+    if (neg) p++;
+
+    // significand
+    std::uint64_t w = 0;
+    int ndigits = 0;
+    int exp10 = 0;
+    bool truncated = false;
+
+    const char* int_begin = p;
+    for (; p != end && util::is_digit(*p); ++p)
+    {
+        if (ndigits < max_digits) {
+            w = 10 * w + (std::uint64_t)(*p - '0');
+            ndigits += w != 0; // ignore leading zeros
+        }
+        else {
+            truncated |= *p != '0';
+            exp10++;
+        }
+    }
+    if (p == int_begin)
+        return false;
+    // no leading zeros
+    if (*int_begin == '0' && p - int_begin > 1)
+        return false;
+
+    if (p != end && *p == '.')
+    {
+        const char* frac_begin = ++p;
+        for (; p != end && util::is_digit(*p); ++p)
+        {
+            if (ndigits < max_digits) {
+                w = 10 * w + (std::uint64_t)(*p - '0');
+                ndigits += w != 0;
+                exp10--;
+            }
+            else truncated |= *p != '0';
+        }
+        if (p == frac_begin)
+            return false;
+    }
+
+    // exponent
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+        bool exp_neg = p != end && *p == '-';
+        if (p != end && (*p == '-' || *p == '+'))
+            p++;
+
+        const char* exp_begin = p;
+        int exp = 0;
+        for (; p != end && util::is_digit(*p); ++p) {
+            if (exp < 100000) // saturate
+                exp = 10 * exp + (*p - '0');
+        }
+        if (p == exp_begin)
+            return false;
+
+        exp10 += exp_neg ? -exp : exp;
+    }
+    if (p != end)
+        return false;
+
+#if FLT_EVAL_METHOD == 0
+    // Clinger's fast path: w and 10^|exp10| are exact, so is the result
+    if (!truncated && w <= traits::max_exact_significand &&
+        exp10 >= -traits::max_exact_exp10 && exp10 <= traits::max_exact_exp10)
+    {
+        auto value = (FloatT)w;
+        if (exp10 < 0)
+            value /= exact_pow10<FloatT>(-exp10);
+        else value *= exact_pow10<FloatT>(exp10);
+
+        out_value = neg ? -value : value;
+        return true;
+    }
+#endif
+
+    binary_fp fp;
+    if (!eisel_lemire<FloatT>(w, exp10, fp))
+        return parse_floating_slow(begin, end, out_value);
+
+    if (truncated)
+    {
+        // value is in [w, w + 1) * 10^exp10,
+        // result is exact if both ends round the same way
+        binary_fp fp_up;
+        if (!eisel_lemire<FloatT>(w + 1, exp10, fp_up) ||
+            fp.significand != fp_up.significand || fp.exponent != fp_up.exponent)
+            return parse_floating_slow(begin, end, out_value);
+    }
+
+    if (fp.exponent == traits::max_biased_exponent)
+        return false; // infinity
+
+    out_value = to_floating<FloatT>(fp, neg);
+    return true;
+}
+
+// Floor of value / 2^n. Assumes signed right shift is arithmetic.
+constexpr int floor_div_pow2(int value, int n) noexcept { return value >> n; }
+
+// floor(log10(2^e)) for e in [-1500, 1500].
+constexpr int floor_log10_pow2(int e) noexcept { return floor_div_pow2(e * 1262611, 22); }
+
+// floor(log10(3/4 * 2^e)) for e in [-1500, 1500].
+constexpr int floor_log10_three_quarters_pow2(int e) noexcept { return floor_div_pow2(e * 1262611 - 524031, 22); }
+
+// floor(log2(10^e)) for e in [-1233, 1233].
+constexpr int floor_log2_pow10(int e) noexcept { return floor_div_pow2(e * 1741647, 19); }
+
+// Decimal floating-point value significand * 10^exponent.
+struct decimal_fp
+{
+    std::uint64_t significand;
+    int exponent;
+};
+
+// Get (g * cp) / 2^128, rounded to odd.
+inline std::uint64_t round_to_odd(uint128 g, std::uint64_t cp) noexcept
+{
+    uint128 x = mul64(g.lo, cp);
+    uint128 y = mul64(g.hi, cp);
+    std::uint64_t z = y.lo + x.hi;
+    std::uint64_t carry = z < y.lo;
+    return (y.hi + carry) | (z > 1);
+}
+
+// Schubfach algorithm. Get the shortest decimal value that
+// rounds to the given positive finite value, choosing the
+// closest one if there are several.
+// https://drive.google.com/file/d/1IEeATSVnEE6TkrHlCYNY2GjaraBjOT4f
+template <typename FloatT>
+inline decimal_fp to_shortest_decimal(FloatT value) noexcept
+{
+    using traits = ieee_traits<FloatT>;
+    using bits_type = typename traits::bits_type;
+    constexpr int mbits = traits::significand_bits;
+    constexpr std::uint64_t hidden_bit = std::uint64_t(1) << mbits;
+
+    bits_type bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    auto ieee_significand = (std::uint64_t)bits & (hidden_bit - 1);
+    auto ieee_exponent = (int)(bits >> mbits) & traits::max_biased_exponent;
+
+    std::uint64_t c;
+    int q;
+    if (ieee_exponent != 0)
+    {
+        c = hidden_bit | ieee_significand;
+        q = ieee_exponent - traits::exponent_bias - mbits;
+
+        // small integers
+        if (-q >= 0 && -q <= mbits && (c & ((std::uint64_t(1) << -q) - 1)) == 0)
+            return { c >> -q, 0 };
+    }
+    else
+    {
+        c = ieee_significand;
+        q = 1 - traits::exponent_bias - mbits;
+    }
+
+    bool is_even = c % 2 == 0;
+    bool lower_boundary_is_closer = ieee_significand == 0 && ieee_exponent > 1;
+
+    std::uint64_t cbl = 4 * c - 2 + lower_boundary_is_closer;
+    std::uint64_t cb = 4 * c;
+    std::uint64_t cbr = 4 * c + 2;
+
+    int k = lower_boundary_is_closer ?
+        floor_log10_three_quarters_pow2(q) : floor_log10_pow2(q);
+    int h = q + floor_log2_pow10(-k) + 1;
+
+    // g = floor(10^-k * 2^r) + 1, normalized to 128 bits
+    const std::uint64_t* p10 = pow10::significand128(-k);
+    uint128 g = { p10[0], p10[1] + 1 };
+    g.hi += g.lo == 0;
+
+    std::uint64_t vbl = round_to_odd(g, cbl << h);
+    std::uint64_t vb = round_to_odd(g, cb << h);
+    std::uint64_t vbr = round_to_odd(g, cbr << h);
+
+    std::uint64_t lower = vbl + !is_even;
+    std::uint64_t upper = vbr - !is_even;
+
+    std::uint64_t s = vb / 4;
+    if (s >= 10)
+    {
+        // try one digit less
+        std::uint64_t sp = s / 10;
+        bool up_inside = lower <= 40 * sp;
+        bool wp_inside = 40 * sp + 40 <= upper;
+        if (up_inside != wp_inside)
+            return { sp + wp_inside, k + 1 };
+    }
+
+    bool u_inside = lower <= 4 * s;
+    bool w_inside = 4 * s + 4 <= upper;
+    if (u_inside != w_inside)
+        return { s + w_inside, k };
+
+    // both candidates are inside, pick the closest (ties to even)
+    std::uint64_t mid = 4 * s + 2;
+    bool round_up = vb > mid || (vb == mid && (s & 1) != 0);
+    return { s + round_up, k };
+}
+
+// "00" to "99", two chars each.
+inline const char* digit_pairs(void) noexcept
+{
+    static const char table[] =
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    return table;
+}
+
+// Number of decimal digits in value.
+template <typename UintT>
+inline int count_digits(UintT value) noexcept
+{
+    int n = 1;
+    for (;;)
+    {
+        if (value < 10) return n;
+        if (value < 100) return n + 1;
+        if (value < 1000) return n + 2;
+        if (value < 10000) return n + 3;
+        value /= 10000u;
+        n += 4;
+    }
+}
+
+// Write the decimal digits of value, ending at last.
+// Two digits at a time, units first.
+template <typename UintT>
+inline void write_digits(char* last, UintT value) noexcept
+{
+    const char* pairs = digit_pairs();
+    while (value >= 100)
+    {
+        auto i = (std::size_t)(value % 100) * 2;
+        value /= 100;
+        last -= 2;
+        std::memcpy(last, pairs + i, 2);
+    }
+    if (value >= 10)
+    {
+        last -= 2;
+        std::memcpy(last, pairs + (std::size_t)value * 2, 2);
+    }
+    else *(--last) = '0' + (char)value;
+}
+
+// Format an unsigned integer. Writes at most
+// util::max_chars10<UintT>::value chars to buf
+// and returns the end of the text.
+template <typename UintT>
+inline char* format_uint(char* buf, UintT value) noexcept
+{
+    char* last = buf + count_digits(value);
+    write_digits(last, value);
+    return last;
+}
+
+// Format a signed integer. Writes at most
+// util::max_chars10<IntT>::value chars to buf
+// and returns the end of the text.
+template <typename IntT>
+inline char* format_int(char* buf, IntT value) noexcept
+{
+    if (value < 0)
+        *buf++ = '-';
+    return format_uint(buf, util::absu(value));
+}
+
+// Max # of chars written by format_floating<FloatT>().
+template <typename FloatT>
+struct format_floating_max_chars : std::integral_constant<int,
+    // sign + digits + point + e + exponent sign + exponent digits
+    1 + std::numeric_limits<FloatT>::max_digits10 + 1 + 1 + 1 + 3>
+{};
+
+// Format a finite value as a JSON number with the fewest digits
+// that read back as the same value (see parse_floating()).
+// Uses exponent notation only if it is shorter. 
+// Writes at most format_floating_max_chars<FloatT>::value chars to 
+// buf and returns the end of the text.
+template <typename FloatT>
+inline char* format_floating(char* buf, FloatT value) noexcept
+{
+    char* p = buf;
+    if (std::signbit(value)) {
+        *p++ = '-';
+        value = -value;
+    }
+    if (value == 0) {
+        *p++ = '0';
+        return p;
+    }
+
+    decimal_fp dec = to_shortest_decimal(value);
+    while (dec.significand % 10 == 0) {
+        dec.significand /= 10;
+        dec.exponent++;
+    }
+
+    int ndigits = count_digits(dec.significand);
+    int point = ndigits + dec.exponent; // position of decimal point
+    int sci_exp = point - 1;
+
+    int sci_len = ndigits + (ndigits > 1) + 1 + (sci_exp < 0) + count_digits(util::absu(sci_exp));
+    int fixed_len = 
+        dec.exponent >= 0 ? point : // integer
+        point > 0 ? ndigits + 1 :   // d.ddd
+        2 - point + ndigits;        // 0.000ddd
+
+    if (fixed_len <= sci_len)
+    {
+        if (dec.exponent >= 0)
+        {
+            write_digits(p + ndigits, dec.significand);
+            std::memset(p + ndigits, '0', (std::size_t)dec.exponent);
+        }
+        else if (point > 0)
+        {
+            write_digits(p + ndigits + 1, dec.significand);
+            std::memmove(p, p + 1, (std::size_t)point);
+            p[point] = '.';
+        }
+        else
+        {
+            p[0] = '0'; p[1] = '.';
+            std::memset(p + 2, '0', (std::size_t)-point);
+            write_digits(p + fixed_len, dec.significand);
+        }
+        return p + fixed_len;
+    }
+    else
+    {
+        // d[.ddd]e[-]xxx
+        write_digits(p + ndigits + 1, dec.significand);
+        p[0] = p[1];
+        if (ndigits > 1) {
+            p[1] = '.';
+            p += ndigits + 1;
+        }
+        else p += 1;
+
+        *p++ = 'e';
+        if (sci_exp < 0) *p++ = '-';
+
+        int exp_digits = count_digits(util::absu(sci_exp));
+        write_digits(p + exp_digits, util::absu(sci_exp));
+        return p + exp_digits;
+    }
+}
+
+}}}
+
+#endif
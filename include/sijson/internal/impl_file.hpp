@@ -4,6 +4,7 @@
 
 #include <cstddef>
 #include <cstdio>
+#include <cassert>
 #include <limits>
 #include <ios>
 #include <string>
@@ -18,14 +19,48 @@
 #include <codecvt>
 #endif
 
+// memory mapping
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 
 namespace sijson {
 namespace internal {
 
+#ifdef _MSC_VER
+inline std::string to_utf8path(const wchar_t filepath[])
+{
+#if _MSVC_LANG < 201703L
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> conv;
+    return conv.to_bytes(filepath);
+#else
+    // todo when std::path support is added
+    // path string is used only for diagnostics at the moment
+    return "<wide filepath>";
+#endif
+}
+#endif
+
 class file
 {
 public:
     static constexpr std::size_t SYS_BUFSIZE = BUFSIZ;
+    // Default buffer size of file streams. BUFSIZ is
+    // often too small to keep up with fast storage.
+    static constexpr std::size_t DEFAULT_BUFSIZE =
+        SYS_BUFSIZE > (1u << 18) ? SYS_BUFSIZE : (1u << 18);
 
     file(const char filepath[], const char mode[]) :
         m_fpath(filepath),
@@ -34,7 +69,7 @@ public:
 
 #ifdef _MSC_VER
     file(const wchar_t filepath[], const wchar_t mode[]) :
-        m_fpath(file::to_utf8path(filepath)),
+        m_fpath(to_utf8path(filepath)),
         m_fptr(file::wopen(filepath, mode))
     {}
 #endif
@@ -67,6 +102,15 @@ public:
     // The file must be open.
     inline void set_unbuffered(void) noexcept { std::setbuf(m_fptr, nullptr); }
 
+    // Hint that the file will be read sequentially.
+    // The file must be open.
+    inline void advise_sequential(void) noexcept
+    {
+#if !defined(_WIN32) && defined(POSIX_FADV_SEQUENTIAL)
+        ::posix_fadvise(::fileno(m_fptr), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+
     // File path encoded as UTF-8.
     inline std::string path(void) const noexcept { return m_fpath; }
 
@@ -131,23 +175,178 @@ private:
             file = nullptr;
         return file;
     }
+#endif
+
+private:
+    std::string m_fpath;
+    std::FILE* m_fptr;
+};
+
+// Read-only memory-mapped file.
+// The entire file is mapped at once.
+class mapped_file
+{
+public:
+    mapped_file(const char filepath[]) :
+        m_fpath(filepath),
+        m_data(nullptr),
+        m_size(0),
+        m_open(false)
+    {
+        assert(filepath);
+#ifdef _WIN32
+        map(::CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+#else
+        map(::open(filepath, O_RDONLY));
+#endif
+    }
 
-    static inline std::string to_utf8path(const wchar_t filepath[])
+#ifdef _MSC_VER
+    mapped_file(const wchar_t filepath[]) :
+        m_fpath(to_utf8path(filepath)),
+        m_data(nullptr),
+        m_size(0),
+        m_open(false)
     {
-#if _MSVC_LANG < 201703L
-        std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> conv;
-        return conv.to_bytes(filepath);
+        map(::CreateFileW(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+    }
+#endif
+
+    mapped_file(mapped_file&& rhs) noexcept :
+        m_fpath(std::move(rhs.m_fpath)),
+        m_data(rhs.m_data),
+        m_size(rhs.m_size),
+        m_open(rhs.m_open)
+    {
+        rhs.m_data = nullptr;
+        rhs.m_size = 0;
+        rhs.m_open = false;
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    mapped_file& operator=(mapped_file&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            close();
+            m_fpath = std::move(rhs.m_fpath);
+            m_data = rhs.m_data;
+            m_size = rhs.m_size;
+            m_open = rhs.m_open;
+            rhs.m_data = nullptr;
+            rhs.m_size = 0;
+            rhs.m_open = false;
+        }
+        return *this;
+    }
+
+    // Returns true if file is ready for use.
+    inline bool is_open(void) const noexcept { return m_open; }
+
+    // File path encoded as UTF-8.
+    inline std::string path(void) const noexcept { return m_fpath; }
+
+    // Start of the mapped contents.
+    // Never null, even if the file is empty.
+    inline const char* data(void) const noexcept { return m_data ? m_data : ""; }
+
+    // Size of the file in bytes.
+    inline std::size_t size(void) const noexcept { return m_size; }
+
+    // Returns true on success.
+    // Whether or not the operation succeeds,
+    // the file will no longer be usable.
+    inline bool close(void) noexcept
+    {
+        bool ok = true;
+        if (m_data)
+        {
+#ifdef _WIN32
+            ok = ::UnmapViewOfFile(m_data) != 0;
 #else
-        // todo when std::path support is added
-        // path string is used only for diagnostics at the moment
-        return "<wide filepath>";
+            ok = ::munmap(const_cast<char*>(m_data), m_size) == 0;
 #endif
+        }
+        m_data = nullptr;
+        m_size = 0;
+        m_open = false;
+        return ok;
+    }
+
+    // Ignore errors on close.
+    ~mapped_file(void) noexcept { close(); }
+
+private:
+#ifdef _WIN32
+    // The mapping remains valid after both handles are closed.
+    inline void map(HANDLE hfile) noexcept
+    {
+        if (hfile == INVALID_HANDLE_VALUE)
+            return;
+
+        LARGE_INTEGER fsize;
+        if (::GetFileSizeEx(hfile, &fsize) &&
+            (unsigned long long)fsize.QuadPart <= std::numeric_limits<std::size_t>::max())
+        {
+            auto size = (std::size_t)fsize.QuadPart;
+            if (size == 0)
+                m_open = true; // cannot map empty files
+            else
+            {
+                HANDLE hmap = ::CreateFileMappingW(hfile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (hmap)
+                {
+                    m_data = static_cast<const char*>(::MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, 0));
+                    if (m_data) {
+                        m_size = size;
+                        m_open = true;
+                    }
+                    ::CloseHandle(hmap);
+                }
+            }
+        }
+        ::CloseHandle(hfile);
+    }
+#else
+    // The mapping remains valid after the descriptor is closed.
+    inline void map(int fd) noexcept
+    {
+        if (fd < 0)
+            return;
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 &&
+            (unsigned long long)st.st_size <= std::numeric_limits<std::size_t>::max())
+        {
+            auto size = (std::size_t)st.st_size;
+            if (size == 0)
+                m_open = true; // cannot map empty files
+            else
+            {
+                void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (addr != MAP_FAILED)
+                {
+                    // hint only, ignore errors
+                    ::madvise(addr, size, MADV_SEQUENTIAL);
+                    m_data = static_cast<const char*>(addr);
+                    m_size = size;
+                    m_open = true;
+                }
+            }
+        }
+        ::close(fd);
     }
 #endif
 
 private:
     std::string m_fpath;
-    std::FILE* m_fptr;
+    const char* m_data;
+    std::size_t m_size;
+    bool m_open;
 };
 }
 
@@ -0,0 +1,228 @@
+//
+// Structural index of in-memory JSON text (stage 1 of indexed reading).
+//
+
+#ifndef SIJSON_INTERNAL_IMPL_INDEX_HPP
+#define SIJSON_INTERNAL_IMPL_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include "util.hpp"
+#include "simd.hpp"
+#include "buffers.hpp"
+
+
+namespace sijson {
+namespace internal {
+
+// Finds chars escaped by backslashes, 64 chars at a time.
+class escape_scanner
+{
+public:
+    escape_scanner(void) noexcept : m_next_is_escaped(0) {}
+
+    // Get mask of escaped chars in the next block,
+    // given the mask of backslashes in the block.
+    inline std::uint64_t next(std::uint64_t backslash) noexcept
+    {
+        if (!backslash)
+        {
+            std::uint64_t escaped = m_next_is_escaped;
+            m_next_is_escaped = 0;
+            return escaped;
+        }
+        // Backslash runs that start on an even bit end in the
+        // opposite parity to runs that start on an odd bit.
+        // Subtracting the runs from the odd bits finds where
+        // each run ends, which tells if it escapes the next char.
+        constexpr std::uint64_t odd_bits = 0xaaaaaaaaaaaaaaaau;
+
+        std::uint64_t potential_escape = backslash & ~m_next_is_escaped;
+        std::uint64_t maybe_escaped = potential_escape << 1;
+        std::uint64_t escape_and_terminal_code =
+            ((maybe_escaped | odd_bits) - potential_escape) ^ odd_bits;
+
+        std::uint64_t escaped = escape_and_terminal_code ^ (backslash | m_next_is_escaped);
+        std::uint64_t escape = escape_and_terminal_code & backslash;
+        m_next_is_escaped = escape >> 63;
+        return escaped;
+    }
+
+private:
+    std::uint64_t m_next_is_escaped;
+};
+
+
+// Positions of the structural chars in JSON text:
+// - {}[]:, outside strings
+// - opening quotes of strings
+// - first chars of all other scalars (numbers, true, false, null),
+//   or of any other run of chars that is not whitespace.
+template <typename Allocator = std::allocator<std::uint32_t>>
+class structural_index
+{
+public:
+    structural_index(const Allocator& alloc = Allocator()) :
+        m_tape(64, alloc), m_size(0)
+    {}
+
+    // Index chars in [first, last). Positions are relative to base.
+    // Returns false if the last string is not terminated.
+    inline bool build(const char* base, const char* first, const char* last)
+    {
+        if ((std::uint64_t)(last - base) > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error("Input is too large to index.");
+
+        m_size = 0;
+
+        escape_scanner escapes;
+        std::uint64_t prev_in_string = 0; // all ones if in string
+        std::uint64_t prev_scalar = 0;
+
+        char tail[64];
+        for (const char* p = first; p < last; p += 64)
+        {
+            const char* blockp = p;
+            if (last - p < 64)
+            {
+                // pad with whitespace
+                std::memset(tail, 0x20, sizeof(tail));
+                std::memcpy(tail, p, (std::size_t)(last - p));
+                blockp = tail;
+            }
+            auto masks = simd::classify_block(blockp);
+
+            std::uint64_t quote = masks.quote & ~escapes.next(masks.backslash);
+
+            // includes opening quotes, excludes closing quotes
+            std::uint64_t in_string = simd::prefix_xor(quote) ^ prev_in_string;
+            prev_in_string = 0 - (in_string >> 63);
+
+            std::uint64_t scalar = ~(masks.op | masks.ws | quote | in_string);
+            std::uint64_t scalar_start = scalar & ~((scalar << 1) | prev_scalar);
+            prev_scalar = scalar >> 63;
+
+            std::uint64_t structurals =
+                (masks.op & ~in_string) | (quote & in_string) | scalar_start;
+
+            m_tape.reserve(m_size + 64);
+            std::uint32_t* out = m_tape.begin() + m_size;
+            auto offset = (std::uint32_t)(p - base);
+            while (structurals)
+            {
+                *out++ = offset + simd::ctz64(structurals);
+                structurals &= structurals - 1;
+            }
+            m_size = (std::size_t)(out - m_tape.begin());
+        }
+        return prev_in_string == 0;
+    }
+
+    // Number of positions.
+    inline std::size_t size(void) const noexcept { return m_size; }
+
+    inline std::uint32_t operator[](std::size_t index) const noexcept
+    {
+        assert(index < m_size);
+        return m_tape[index];
+    }
+
+private:
+    buffer<std::uint32_t, Allocator> m_tape;
+    std::size_t m_size;
+};
+
+
+// Finds the boundaries of the elements of a JSON array, i.e. the
+// commas and closing brackets outside strings and nested values.
+class array_scanner
+{
+public:
+    // Scan [first, last). first must be inside the array,
+    // and outside any string or nested value.
+    array_scanner(const char* first, const char* last) noexcept :
+        m_block(first), m_next(first), m_last(last),
+        m_ops(0), m_prev_in_string(0), m_depth(0)
+    {}
+
+    // Get pointer to the next ',' in the array, or to the closing
+    // bracket of the array (which may be unmatched, e.g. '}').
+    // Returns last if there are none.
+    inline const char* next(void) noexcept
+    {
+        while (true)
+        {
+            while (m_ops)
+            {
+                const char* p = m_block + simd::ctz64(m_ops);
+                m_ops &= m_ops - 1;
+
+                switch (*p)
+                {
+                    case '{':
+                    case '[':
+                        m_depth++;
+                        break;
+                    case '}':
+                    case ']':
+                        if (m_depth == 0)
+                            return p;
+                        m_depth--;
+                        break;
+                    case ',':
+                        if (m_depth == 0)
+                            return p;
+                        break;
+                    default: break;
+                }
+            }
+            if (m_next >= m_last)
+                return m_last;
+
+            next_block();
+        }
+    }
+
+private:
+    inline void next_block(void) noexcept
+    {
+        m_block = m_next;
+        m_next += 64;
+
+        char tail[64];
+        const char* blockp = m_block;
+        if (m_last - m_block < 64)
+        {
+            // pad with whitespace
+            std::memset(tail, 0x20, sizeof(tail));
+            std::memcpy(tail, m_block, (std::size_t)(m_last - m_block));
+            blockp = tail;
+        }
+        auto masks = simd::classify_block(blockp);
+
+        std::uint64_t quote = masks.quote & ~m_escapes.next(masks.backslash);
+        std::uint64_t in_string = simd::prefix_xor(quote) ^ m_prev_in_string;
+        m_prev_in_string = 0 - (in_string >> 63);
+
+        m_ops = masks.op & ~in_string;
+    }
+
+private:
+    const char* m_block; // start of current block
+    const char* m_next; // start of next block
+    const char* m_last;
+    std::uint64_t m_ops; // unvisited {}[]:, in current block
+    std::uint64_t m_prev_in_string; // all ones if in string
+    std::size_t m_depth;
+    escape_scanner m_escapes;
+};
+
+}}
+
+#endif
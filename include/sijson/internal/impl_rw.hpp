@@ -2,14 +2,16 @@
 #ifndef SIJSON_INTERNAL_IMPL_RW_HPP
 #define SIJSON_INTERNAL_IMPL_RW_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <cassert>
 #include <bitset>
 #include <type_traits>
 #include <memory>
 #include <iostream>
 #include <string>
-#include <stack>
-#include <deque>
+#include <algorithm>
+#include <utility>
 #include <stdexcept>
 
 #include "common.hpp"
@@ -19,20 +21,213 @@
 namespace sijson {
 namespace internal {
 
-class rw_util
+struct node_info
 {
-protected:
-    struct node_info
+    doc_node_t type;
+    bool has_children;
+
+    node_info(doc_node_t type) :
+        type(type), has_children(false)
     {
-        const doc_node_t type;
-        bool has_children;
+        assert(type < NUM_DOCNODE_TYPES);
+    }
+};
+
+// Stack of node_info, packed into 4 bits per node.
+// The top node is kept unpacked. Up to INLINE_NODES nodes below it
+// are stored inline, so no allocation is needed for most documents.
+template <typename Allocator>
+class node_stack : iutil::alloc_aware_container<iutil::rebind_alloc_t<Allocator, std::uint64_t>>
+{
+private:
+    using word_allocator = iutil::rebind_alloc_t<Allocator, std::uint64_t>;
+    using base = iutil::alloc_aware_container<word_allocator>;
+
+    static_assert(NUM_DOCNODE_TYPES <= 8, "Node type does not fit in 3 bits.");
+
+    static constexpr std::size_t NODES_PER_WORD = 16;
+    static constexpr std::size_t INLINE_WORDS = 4;
+    static constexpr std::size_t INLINE_NODES = NODES_PER_WORD * INLINE_WORDS;
+
+public:
+    node_stack(void) :
+        m_top(DOCNODE_root), m_size(0), m_inline(),
+        m_heap(nullptr), m_heap_words(0)
+    {}
 
-        node_info(doc_node_t type) :
-            type(type), has_children(false)
+    node_stack(const word_allocator& alloc) :
+        base(alloc), m_top(DOCNODE_root), m_size(0), m_inline(),
+        m_heap(nullptr), m_heap_words(0)
+    {}
+
+    node_stack(const node_stack& rhs) :
+        base(rhs), m_top(rhs.m_top), m_size(0),
+        m_heap(nullptr), m_heap_words(0)
+    {
+        copy_from(rhs);
+    }
+
+    node_stack(node_stack&& rhs) noexcept :
+        base(std::move(rhs)), m_top(rhs.m_top), m_size(rhs.m_size),
+        m_heap(rhs.m_heap), m_heap_words(rhs.m_heap_words)
+    {
+        std::copy(rhs.m_inline, rhs.m_inline + INLINE_WORDS, m_inline);
+        rhs.m_heap = nullptr;
+        rhs.m_heap_words = 0;
+        rhs.m_size = 0;
+    }
+
+    node_stack& operator=(const node_stack& rhs)
+    {
+        if (this != &rhs)
+        {
+            free_heap();
+            base::operator=(rhs);
+            copy_from(rhs);
+        }
+        return *this;
+    }
+
+    node_stack& operator=(node_stack&& rhs)
+    {
+        if (this != &rhs)
+        {
+            free_heap();
+            base::operator=(std::move(rhs));
+            if (this->alloc() == rhs.alloc())
+            {
+                m_top = rhs.m_top;
+                m_size = rhs.m_size;
+                std::copy(rhs.m_inline, rhs.m_inline + INLINE_WORDS, m_inline);
+                m_heap = rhs.m_heap;
+                m_heap_words = rhs.m_heap_words;
+                rhs.m_heap = nullptr;
+                rhs.m_heap_words = 0;
+                rhs.m_size = 0;
+            }
+            else copy_from(rhs);
+        }
+        return *this;
+    }
+
+    inline bool empty(void) const noexcept { return m_size == 0; }
+
+    // Remove all nodes. Keeps allocated memory.
+    inline void clear(void) noexcept { m_size = 0; }
+    inline std::size_t size(void) const noexcept { return m_size; }
+
+    // Get top node. Stack must not be empty.
+    inline node_info& top(void) noexcept { assert(m_size != 0); return m_top; }
+    inline const node_info& top(void) const noexcept { assert(m_size != 0); return m_top; }
+
+    inline void push(node_info node)
+    {
+        if (m_size != 0)
+        {
+            std::size_t index = m_size - 1;
+            if (index >= INLINE_NODES &&
+                (index - INLINE_NODES) / NODES_PER_WORD >= m_heap_words)
+                grow();
+
+            std::uint64_t& w = word(index);
+            unsigned shift = shift_of(index);
+            w = (w & ~(std::uint64_t(0xf) << shift)) | (std::uint64_t(pack(m_top)) << shift);
+        }
+        m_top = node;
+        m_size++;
+    }
+
+    // Stack must not be empty.
+    inline void pop(void) noexcept
+    {
+        assert(m_size != 0);
+        m_size--;
+        if (m_size != 0)
         {
-            assert(type < NUM_DOCNODE_TYPES);
+            std::size_t index = m_size - 1;
+            m_top = unpack((unsigned)(word(index) >> shift_of(index)) & 0xf);
         }
-    };
+    }
+
+    ~node_stack(void) { free_heap(); }
+
+private:
+    static inline unsigned pack(const node_info& node) noexcept
+    {
+        return (unsigned)node.type | (node.has_children ? 0x8u : 0u);
+    }
+
+    static inline node_info unpack(unsigned bits) noexcept
+    {
+        node_info node((doc_node_t)(bits & 0x7));
+        node.has_children = (bits & 0x8) != 0;
+        return node;
+    }
+
+    static inline unsigned shift_of(std::size_t index) noexcept
+    {
+        return (unsigned)(index % NODES_PER_WORD) * 4;
+    }
+
+    inline std::uint64_t& word(std::size_t index) noexcept
+    {
+        return index < INLINE_NODES ?
+            m_inline[index / NODES_PER_WORD] :
+            m_heap[(index - INLINE_NODES) / NODES_PER_WORD];
+    }
+
+    inline std::size_t heap_words_used(void) const noexcept
+    {
+        return m_size > INLINE_NODES + 1 ?
+            (m_size - 1 - INLINE_NODES + NODES_PER_WORD - 1) / NODES_PER_WORD : 0;
+    }
+
+    inline void grow(void)
+    {
+        std::size_t new_words = m_heap_words == 0 ? INLINE_WORDS : 2 * m_heap_words;
+        std::uint64_t* heap = iutil::alloc_new<std::uint64_t>(this->alloc(), new_words);
+
+        std::copy(m_heap, m_heap + m_heap_words, heap);
+        iutil::alloc_delete(this->alloc(), m_heap, m_heap_words);
+
+        m_heap = heap;
+        m_heap_words = new_words;
+    }
+
+    // Heap must be freed.
+    inline void copy_from(const node_stack& rhs)
+    {
+        std::size_t words = rhs.heap_words_used();
+        if (words != 0)
+            m_heap = iutil::alloc_new<std::uint64_t>(this->alloc(), words);
+
+        m_heap_words = words;
+        std::copy(rhs.m_heap, rhs.m_heap + words, m_heap);
+        std::copy(rhs.m_inline, rhs.m_inline + INLINE_WORDS, m_inline);
+        m_top = rhs.m_top;
+        m_size = rhs.m_size;
+    }
+
+    inline void free_heap(void) noexcept
+    {
+        iutil::alloc_delete(this->alloc(), m_heap, m_heap_words);
+        m_heap = nullptr;
+        m_heap_words = 0;
+    }
+
+private:
+    node_info m_top;
+    std::size_t m_size;
+    std::uint64_t m_inline[INLINE_WORDS];
+    std::uint64_t* m_heap;
+    std::size_t m_heap_words;
+};
+
+
+class rw_util
+{
+protected:
+    using node_info = internal::node_info;
 
     static inline std::runtime_error
         bad_top_node_error(const std::bitset<NUM_DOCNODE_TYPES> expected)
@@ -124,8 +319,7 @@ protected:
     }
 
 protected:
-    std::stack<node_info, std::deque<node_info,
-        iutil::rebind_alloc_t<AllocatorPolicy, node_info>>> m_nodes;
+    node_stack<AllocatorPolicy> m_nodes;
 };
 
 static const char EXSTR_multi_root[] = "Document cannot have more than one root element.";
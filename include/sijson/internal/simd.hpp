@@ -0,0 +1,264 @@
+//
+// Vectorized scanning of contiguous character data.
+// Uses SSE2/AVX2 if enabled by the compiler, with scalar fallbacks.
+// Define SIJSON_NO_SIMD to always use the scalar fallbacks.
+// Should not have dependencies outside of internal/.
+//
+
+#ifndef SIJSON_INTERNAL_SIMD_HPP
+#define SIJSON_INTERNAL_SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef SIJSON_NO_SIMD
+#if defined(__AVX2__)
+#define SIJSON_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIJSON_SSE2
+#endif
+#endif
+
+#if defined(SIJSON_AVX2)
+#include <immintrin.h>
+#elif defined(SIJSON_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(SIJSON_SSE2) || defined(SIJSON_AVX2))
+#include <intrin.h>
+#endif
+
+
+namespace sijson {
+namespace internal {
+namespace simd {
+
+// Index of the lowest set bit. Mask must be non-zero.
+inline unsigned ctz32(std::uint32_t mask) noexcept
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return (unsigned)idx;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+// Index of the lowest set bit. Mask must be non-zero.
+inline unsigned ctz64(std::uint64_t mask) noexcept
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx;
+    _BitScanForward64(&idx, mask);
+    return (unsigned)idx;
+#elif defined(_MSC_VER)
+    auto lo = (std::uint32_t)mask;
+    return lo != 0 ? ctz32(lo) : 32 + ctz32((std::uint32_t)(mask >> 32));
+#else
+    return (unsigned)__builtin_ctzll(mask);
+#endif
+}
+
+inline bool is_ws(char c) noexcept
+{
+    return c == 0x20 || c == 0x09 || c == 0x0a || c == 0x0d;
+}
+
+// Get pointer to the first char in [begin, end)
+// that is not JSON whitespace, or end if none.
+inline const char* find_non_ws(const char* begin, const char* end) noexcept
+{
+    const char* p = begin;
+#ifdef SIJSON_AVX2
+    const __m256i sp32 = _mm256_set1_epi8(0x20);
+    const __m256i ht32 = _mm256_set1_epi8(0x09);
+    const __m256i lf32 = _mm256_set1_epi8(0x0a);
+    const __m256i cr32 = _mm256_set1_epi8(0x0d);
+
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, sp32), _mm256_cmpeq_epi8(v, ht32)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, lf32), _mm256_cmpeq_epi8(v, cr32)));
+
+        auto mask = ~(std::uint32_t)_mm256_movemask_epi8(ws);
+        if (mask != 0)
+            return p + ctz32(mask);
+    }
+#endif
+#ifdef SIJSON_SSE2
+    const __m128i sp16 = _mm_set1_epi8(0x20);
+    const __m128i ht16 = _mm_set1_epi8(0x09);
+    const __m128i lf16 = _mm_set1_epi8(0x0a);
+    const __m128i cr16 = _mm_set1_epi8(0x0d);
+
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, sp16), _mm_cmpeq_epi8(v, ht16)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, lf16), _mm_cmpeq_epi8(v, cr16)));
+
+        auto mask = ~(std::uint32_t)_mm_movemask_epi8(ws) & 0xFFFF;
+        if (mask != 0)
+            return p + ctz32(mask);
+    }
+#endif
+    while (p != end && is_ws(*p)) 
+        p++;
+    return p;
+}
+
+// Get pointer to the first char in [begin, end)
+// that is equal to a or b, or end if none.
+inline const char* find_first_of(const char* begin, const char* end, char a, char b) noexcept
+{
+    const char* p = begin;
+#ifdef SIJSON_AVX2
+    const __m256i a32 = _mm256_set1_epi8(a);
+    const __m256i b32 = _mm256_set1_epi8(b);
+
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i eq = _mm256_or_si256(_mm256_cmpeq_epi8(v, a32), _mm256_cmpeq_epi8(v, b32));
+
+        auto mask = (std::uint32_t)_mm256_movemask_epi8(eq);
+        if (mask != 0)
+            return p + ctz32(mask);
+    }
+#endif
+#ifdef SIJSON_SSE2
+    const __m128i a16 = _mm_set1_epi8(a);
+    const __m128i b16 = _mm_set1_epi8(b);
+
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i eq = _mm_or_si128(_mm_cmpeq_epi8(v, a16), _mm_cmpeq_epi8(v, b16));
+
+        auto mask = (std::uint32_t)_mm_movemask_epi8(eq);
+        if (mask != 0)
+            return p + ctz32(mask);
+    }
+#endif
+    while (p != end && *p != a && *p != b)
+        p++;
+    return p;
+}
+
+// Bitmasks of chars in a 64-byte block.
+// Bit i corresponds to the char at index i.
+struct block_masks
+{
+    std::uint64_t quote;
+    std::uint64_t backslash;
+    std::uint64_t op; // {}[]:,
+    std::uint64_t ws;
+};
+
+// Classify 64 chars starting at p.
+inline block_masks classify_block(const char* p) noexcept
+{
+    block_masks m;
+#if defined(SIJSON_AVX2)
+    const __m256i quote32 = _mm256_set1_epi8('"');
+    const __m256i bslash32 = _mm256_set1_epi8('\\');
+    const __m256i lbrace32 = _mm256_set1_epi8('{');
+    const __m256i rbrace32 = _mm256_set1_epi8('}');
+    const __m256i colon32 = _mm256_set1_epi8(':');
+    const __m256i comma32 = _mm256_set1_epi8(',');
+    const __m256i case32 = _mm256_set1_epi8(0x20);
+    const __m256i sp32 = _mm256_set1_epi8(0x20);
+    const __m256i ht32 = _mm256_set1_epi8(0x09);
+    const __m256i lf32 = _mm256_set1_epi8(0x0a);
+    const __m256i cr32 = _mm256_set1_epi8(0x0d);
+
+    std::uint64_t quote[2], bslash[2], op[2], ws[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * i));
+        // '[' | 0x20 == '{', ']' | 0x20 == '}'
+        __m256i vl = _mm256_or_si256(v, case32);
+
+        quote[i] = (std::uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote32));
+        bslash[i] = (std::uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, bslash32));
+        op[i] = (std::uint32_t)_mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(vl, lbrace32), _mm256_cmpeq_epi8(vl, rbrace32)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, colon32), _mm256_cmpeq_epi8(v, comma32))));
+        ws[i] = (std::uint32_t)_mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, sp32), _mm256_cmpeq_epi8(v, ht32)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, lf32), _mm256_cmpeq_epi8(v, cr32))));
+    }
+    m.quote = quote[0] | quote[1] << 32;
+    m.backslash = bslash[0] | bslash[1] << 32;
+    m.op = op[0] | op[1] << 32;
+    m.ws = ws[0] | ws[1] << 32;
+#elif defined(SIJSON_SSE2)
+    const __m128i quote16 = _mm_set1_epi8('"');
+    const __m128i bslash16 = _mm_set1_epi8('\\');
+    const __m128i lbrace16 = _mm_set1_epi8('{');
+    const __m128i rbrace16 = _mm_set1_epi8('}');
+    const __m128i colon16 = _mm_set1_epi8(':');
+    const __m128i comma16 = _mm_set1_epi8(',');
+    const __m128i case16 = _mm_set1_epi8(0x20);
+    const __m128i sp16 = _mm_set1_epi8(0x20);
+    const __m128i ht16 = _mm_set1_epi8(0x09);
+    const __m128i lf16 = _mm_set1_epi8(0x0a);
+    const __m128i cr16 = _mm_set1_epi8(0x0d);
+
+    m.quote = m.backslash = m.op = m.ws = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+        // '[' | 0x20 == '{', ']' | 0x20 == '}'
+        __m128i vl = _mm_or_si128(v, case16);
+        int shift = 16 * i;
+
+        m.quote |= (std::uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote16)) << shift;
+        m.backslash |= (std::uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, bslash16)) << shift;
+        m.op |= (std::uint64_t)_mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(vl, lbrace16), _mm_cmpeq_epi8(vl, rbrace16)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, colon16), _mm_cmpeq_epi8(v, comma16)))) << shift;
+        m.ws |= (std::uint64_t)_mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, sp16), _mm_cmpeq_epi8(v, ht16)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, lf16), _mm_cmpeq_epi8(v, cr16)))) << shift;
+    }
+#else
+    m.quote = m.backslash = m.op = m.ws = 0;
+    for (int i = 0; i < 64; ++i)
+    {
+        std::uint64_t bit = std::uint64_t(1) << i;
+        switch (p[i])
+        {
+            case '"': m.quote |= bit; break;
+            case '\\': m.backslash |= bit; break;
+            case '{': case '}': case '[': case ']':
+            case ':': case ',': m.op |= bit; break;
+            case 0x20: case 0x09: case 0x0a: case 0x0d: m.ws |= bit; break;
+            default: break;
+        }
+    }
+#endif
+    return m;
+}
+
+// Bit i of the result is the XOR of bits [0, i] of mask.
+inline std::uint64_t prefix_xor(std::uint64_t mask) noexcept
+{
+    mask ^= mask << 1;
+    mask ^= mask << 2;
+    mask ^= mask << 4;
+    mask ^= mask << 8;
+    mask ^= mask << 16;
+    mask ^= mask << 32;
+    return mask;
+}
+
+}}}
+
+#endif
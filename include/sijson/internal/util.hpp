@@ -18,6 +18,8 @@
 #include <algorithm>
 #include <stdexcept>
 
+#include "simd.hpp"
+
 
 #ifndef SIJSON_CPLUSPLUS
 #ifdef _MSC_VER
@@ -210,6 +212,57 @@ struct max_chars10 : std::conditional<
 {};
 
 
+// True if T gives direct access to its input data and can extract
+// chars in bulk, i.e. implements indata() (see is_idata_spannable)
+// and advance(std::size_t count).
+template <typename T, typename = void>
+struct has_contiguous_input : std::false_type {};
+
+template <typename T>
+struct has_contiguous_input<T, void_t<
+    decltype(std::declval<const T>().indata().begin),
+    decltype(std::declval<T>().advance(std::declval<std::size_t>()))>> : std::true_type
+{};
+
+// True if T exposes its buffered input and can extract
+// chars in bulk (see is_iwindowed).
+template <typename T, typename = void>
+struct has_input_window : std::false_type {};
+
+template <typename T>
+struct has_input_window<T, void_t<
+    decltype(std::declval<T>().window().begin),
+    decltype(std::declval<T>().advance(std::declval<std::size_t>()))>> : std::true_type
+{};
+
+// True if T has fixed output space, i.e. implements
+// std::size_t avail() const (see basic_ostrspanstream).
+template <typename T, typename = void>
+struct has_fixed_output : std::false_type {};
+
+template <typename T>
+struct has_fixed_output<T, void_t<
+    require_same_t<decltype(std::declval<const T>().avail()), std::size_t>>> : std::true_type
+{};
+
+// True if count chars can be reserved in stream.
+// Streams without fixed output grow on reserve.
+template <typename Ostream>
+inline bool can_reserve(const Ostream&, std::size_t, std::false_type) noexcept { return true; }
+
+template <typename Ostream>
+inline bool can_reserve(const Ostream& stream, std::size_t count, std::true_type) noexcept
+{
+    return count <= stream.avail();
+}
+
+template <typename Ostream>
+inline bool can_reserve(const Ostream& stream, std::size_t count) noexcept
+{
+    return can_reserve(stream, count, has_fixed_output<Ostream>{});
+}
+
+
 template <typename T, typename = void>
 struct alloc_is_always_equal : std::is_empty<T> {};
 
@@ -563,9 +616,8 @@ inline bool starts_with(const_iterator str_begin,
     return true;
 }
 
-// Returns true if stream has more characters.
 template <typename Istream>
-inline bool skip_ws(Istream& stream)
+inline bool skip_ws_impl(Istream& stream, std::false_type)
 {
     while (!stream.end() && is_ws(stream.peek())) {
         stream.take();
@@ -573,6 +625,33 @@ inline bool skip_ws(Istream& stream)
     return !stream.end();
 }
 
+template <typename Istream>
+inline bool skip_ws_impl(Istream& stream, std::true_type)
+{
+    while (true)
+    {
+        auto window = stream.window();
+        if (window.begin == window.end)
+            return false;
+
+        // usually no whitespace at all
+        if (!is_ws(*window.begin))
+            return true;
+
+        const char* next = simd::find_non_ws(window.begin, window.end);
+        stream.advance((std::size_t)(next - window.begin));
+        if (next != window.end)
+            return true;
+    }
+}
+
+// Returns true if stream has more characters.
+template <typename Istream>
+inline bool skip_ws(Istream& stream)
+{
+    return skip_ws_impl(stream, has_input_window<Istream>{});
+}
+
 // Returns true if stream has more characters.
 template <typename Istream>
 inline bool skip_ws(Istream& stream, std::size_t& out_finalpos)
@@ -0,0 +1,169 @@
+//
+// Set of object keys, for matching keys in any order.
+//
+
+#ifndef SIJSON_KEYSET_HPP
+#define SIJSON_KEYSET_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+
+namespace sijson {
+
+namespace internal { class keyset_ostream; }
+
+// Set of object keys, for ascii_reader::read_key_index().
+// The index of a key is its position in the list it was built from.
+// Keys are copied.
+class key_set
+{
+public:
+    // Index of keys not in the set.
+    static constexpr std::size_t npos = (std::size_t)-1;
+
+    // Throws if a key is repeated.
+    key_set(std::initializer_list<const char*> keys) :
+        key_set(keys.begin(), keys.size())
+    {}
+
+    // Throws if a key is repeated.
+    key_set(const char* const* keys, std::size_t count)
+    {
+        m_entries.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::size_t length = std::strlen(keys[i]);
+            m_entries.push_back({ m_chars.size(), length, i });
+            m_chars.append(keys[i], length);
+        }
+
+        std::sort(m_entries.begin(), m_entries.end(),
+            [&](const entry& a, const entry& b) { return compare(a, b) < 0; });
+
+        for (std::size_t i = 1; i < m_entries.size(); ++i)
+        {
+            if (compare(m_entries[i - 1], m_entries[i]) == 0)
+                throw std::invalid_argument("Repeated key \"" +
+                    m_chars.substr(m_entries[i].offset, m_entries[i].length) + "\"");
+        }
+    }
+
+    // Number of keys.
+    inline std::size_t size(void) const noexcept { return m_entries.size(); }
+
+    // Find key. Returns its index, or npos if not found.
+    inline std::size_t find(const char* key, std::size_t length) const noexcept;
+
+private:
+    friend class internal::keyset_ostream;
+
+    struct entry
+    {
+        std::size_t offset;
+        std::size_t length;
+        // Position in the list of keys.
+        std::size_t index;
+    };
+
+    inline int compare(const entry& a, const entry& b) const noexcept
+    {
+        int cmp = std::memcmp(m_chars.data() + a.offset, m_chars.data() + b.offset, std::min(a.length, b.length));
+        if (cmp != 0) return cmp;
+        return a.length < b.length ? -1 : (a.length > b.length ? 1 : 0);
+    }
+
+    // Char at pos in the key, or -1 if the key is shorter.
+    // Keys with a common prefix of length pos are sorted by this.
+    inline int char_at(const entry& e, std::size_t pos) const noexcept
+    {
+        return pos < e.length ? (int)(unsigned char)m_chars[e.offset + pos] : -1;
+    }
+
+private:
+    // Keys, in order.
+    std::string m_chars;
+    // Sorted by key.
+    std::vector<entry> m_entries;
+};
+
+
+namespace internal {
+
+// Output stream that finds the chars written in a key_set.
+// Each char narrows the range of keys that it can match, so
+// the key is matched as it is read and is never stored.
+class keyset_ostream
+{
+public:
+    keyset_ostream(const key_set& keys) noexcept :
+        m_keys(keys), m_first(0), m_last(keys.m_entries.size()), m_pos(0)
+    {}
+
+    inline void put(char c)
+    {
+        if (m_first != m_last)
+        {
+            auto& entries = m_keys.m_entries;
+            int ch = (int)(unsigned char)c;
+            std::size_t pos = m_pos;
+
+            m_first = (std::size_t)(std::lower_bound(entries.begin() + m_first, entries.begin() + m_last, ch,
+                [&](const key_set::entry& e, int value) { return m_keys.char_at(e, pos) < value; }) - entries.begin());
+            m_last = (std::size_t)(std::upper_bound(entries.begin() + m_first, entries.begin() + m_last, ch,
+                [&](int value, const key_set::entry& e) { return value < m_keys.char_at(e, pos); }) - entries.begin());
+        }
+        m_pos++;
+    }
+
+    inline void putn(const char* str, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (m_first == m_last)
+            {   // no key can match
+                m_pos += count - i;
+                return;
+            }
+            put(str[i]);
+        }
+    }
+
+    // Index of the chars written in the key_set, or key_set::npos.
+    inline std::size_t index(void) const noexcept
+    {
+        // a key equal to the chars written sorts before
+        // the others that start with them
+        if (m_first != m_last && m_keys.m_entries[m_first].length == m_pos)
+            return m_keys.m_entries[m_first].index;
+        return key_set::npos;
+    }
+
+    // Number of chars written.
+    inline std::size_t outpos(void) const noexcept { return m_pos; }
+
+private:
+    const key_set& m_keys;
+    // Range of keys that start with the chars written.
+    std::size_t m_first;
+    std::size_t m_last;
+    std::size_t m_pos;
+};
+
+}
+
+inline std::size_t key_set::find(const char* key, std::size_t length) const noexcept
+{
+    internal::keyset_ostream os(*this);
+    os.putn(key, length);
+    return os.index();
+}
+
+}
+
+#endif
@@ -39,6 +39,13 @@ public:
     // Extract character. If end(), behavior is undefined.
     inline char take(void) noexcept { return *m_cur++; }
 
+    // Extract count characters. If fewer than count
+    // characters remain, behavior is undefined.
+    inline void advance(std::size_t count) noexcept { m_cur += count; }
+
+    // Span of the remaining input i.e. from inpos() to inlength().
+    inline memspan<const char> window(void) const noexcept { return { m_cur, m_end }; }
+
     // Get input position.
     inline std::size_t inpos(void) const noexcept { return (std::size_t)(m_cur - m_begin); }
 
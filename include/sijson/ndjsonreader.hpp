@@ -0,0 +1,163 @@
+
+#ifndef SIJSON_NDJSONREADER_HPP
+#define SIJSON_NDJSONREADER_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <algorithm>
+
+#include "internal/util.hpp"
+
+#include "common.hpp"
+#include "reader.hpp"
+#include "stdstream.hpp"
+
+
+namespace sijson {
+namespace internal {
+
+// Input stream over the current line of another input stream.
+// end() is true at the newline, which is not taken.
+template <typename Istream>
+class line_istream
+{
+public:
+    line_istream(Istream& stream) :
+        m_stream(stream)
+    {
+        new_line();
+    }
+
+    inline char peek(void) { return m_stream.peek(); }
+    inline char take(void) { return m_stream.take(); }
+    inline std::size_t inpos(void) { return m_stream.inpos(); }
+    inline bool end(void) { return m_stream.end() || m_stream.peek() == '\n'; }
+
+    template <typename S = Istream, 
+        iutil::require_t<iutil::has_input_window<S>::value> = 0>
+    inline void advance(std::size_t count) { m_stream.advance(count); }
+
+    // Window of the underlying stream, up to the newline.
+    template <typename S = Istream, 
+        iutil::require_t<iutil::has_input_window<S>::value> = 0>
+    inline memspan<const char> window(void)
+    {
+        auto window = m_stream.window();
+        std::size_t pos = m_stream.inpos();
+        std::size_t window_end = pos + window.size();
+
+        // scan each char once, positions are stable across refills
+        if (m_line_end == NPOS && m_scanned < window_end)
+        {
+            std::size_t from = std::max(m_scanned, pos);
+            auto nl = (const char*)std::memchr(window.begin + (from - pos), '\n', window_end - from);
+            if (nl)
+                m_line_end = pos + (std::size_t)(nl - window.begin);
+            else m_scanned = window_end;
+        }
+        std::size_t count = std::min(window.size(), m_line_end - pos);
+        return { window.begin, window.begin + count };
+    }
+
+    // Move past the newline, to the start of the next line.
+    inline void next_line(void)
+    {
+        while (!m_stream.end() && m_stream.take() != '\n') {}
+        new_line();
+    }
+
+    inline void new_line(void) noexcept
+    {
+        m_line_end = NPOS;
+        m_scanned = 0;
+    }
+
+private:
+    static constexpr std::size_t NPOS = std::numeric_limits<std::size_t>::max();
+
+    Istream& m_stream;
+    // Stream position of the newline, or NPOS if not found yet.
+    std::size_t m_line_end;
+    // Stream position up to which there is no newline.
+    std::size_t m_scanned;
+};
+}
+
+// Reader for newline-delimited JSON (NDJSON/JSON Lines).
+//
+// Each line of the stream is a record containing one JSON document.
+// Call next_record() to move to a record, then read it with reader().
+// The reader cannot read past the end of the line. If reading a record
+// throws, call next_record() to continue from the next line.
+// The reader and its buffers are reused for all records.
+//
+template <typename Istream,
+    // Allocator type used for internal purposes/book-keeping.
+    typename AllocatorPolicy = std::allocator<void>>
+class ndjson_reader
+{
+private:
+    using JsonIstream = wrap_std_istream_t<Istream>;
+    using line_stream = internal::line_istream<JsonIstream>;
+
+public:
+    using reader_type = ascii_reader<line_stream, AllocatorPolicy>;
+
+public:
+    ndjson_reader(Istream& stream) :
+        m_stream(stream),
+        m_line(m_stream),
+        m_reader(m_line),
+        m_in_record(false),
+        m_offset(0)
+    {}
+
+    // members reference each other
+    ndjson_reader(ndjson_reader&&) = delete;
+    ndjson_reader(const ndjson_reader&) = delete;
+
+    ndjson_reader& operator=(ndjson_reader&&) = delete;
+    ndjson_reader& operator=(const ndjson_reader&) = delete;
+
+    // Move to the next record. Skips the unread part of the
+    // current record and any blank lines.
+    // Returns false if there are no more records.
+    inline bool next_record(void)
+    {
+        if (m_in_record)
+            m_line.next_line();
+
+        m_in_record = iutil::skip_ws(m_stream);
+        if (m_in_record)
+        {
+            m_line.new_line();
+            m_offset = m_stream.inpos();
+            m_reader.reset();
+        }
+        return m_in_record;
+    }
+
+    // Reader for the current record.
+    // To check that a record has nothing after its
+    // value, check that token() returns TOKEN_eof.
+    inline reader_type& reader(void) noexcept { return m_reader; }
+
+    // Stream position of the start of the current record.
+    inline std::size_t record_offset(void) const noexcept { return m_offset; }
+
+    // Get stream.
+    inline JsonIstream& stream(void) noexcept { return m_stream; }
+
+private:
+    wrap_std_istream_t<Istream&> m_stream;
+    line_stream m_line;
+    reader_type m_reader;
+    bool m_in_record;
+    std::size_t m_offset;
+};
+
+}
+
+#endif
@@ -0,0 +1,392 @@
+//
+// On-demand reader: iterate objects and arrays with cursors,
+// parsing values only when they are used.
+//
+
+#ifndef SIJSON_ONDEMAND_HPP
+#define SIJSON_ONDEMAND_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <stdexcept>
+
+#include "internal/util.hpp"
+#include "internal/buffers.hpp"
+#include "internal/impl_rw.hpp"
+
+#include "common.hpp"
+#include "stats.hpp"
+#include "reader.hpp"
+
+
+namespace sijson {
+
+template <typename Reader> class value_handle;
+template <typename Reader> class array_cursor;
+template <typename Reader> class object_cursor;
+
+namespace internal { template <typename Reader, typename Deref> class cursor_iterator; }
+
+// On-demand JSON reader.
+//
+// eg.
+//   ondemand_reader<imstream> r(is);
+//   for (auto item : r.value().get_array())
+//       total += item.get<double>();
+//
+// Values are read in document order, in one pass. A value is parsed
+// when its handle is converted, and skipped if the cursor moves past it
+// without it being used. Cursors that are left before their end are
+// skipped to the end when their parent moves on. Moving a cursor after
+// its container ended throws, like converting a handle twice.
+template <typename Istream,
+    // Allocator type used for internal purposes/book-keeping.
+    typename AllocatorPolicy = std::allocator<void>,
+    // Statistics to collect (no_stats or collect_stats).
+    typename StatsPolicy = no_stats>
+class ondemand_reader
+{
+public:
+    using raw_reader_type = raw_ascii_reader<Istream, StatsPolicy>;
+
+    ondemand_reader(Istream& stream) :
+        m_rr{ stream },
+        m_key(internal::make_string_view(nullptr, nullptr)),
+        m_serial(0)
+    {
+        m_nodes.push({ DOCNODE_root });
+    }
+
+    // Get handle to the next root value in the stream.
+    // Anything left of the previous root value is skipped.
+    inline value_handle<ondemand_reader> value(void)
+    {
+        finish_nodes(1);
+        start_value();
+        return { *this, m_serial };
+    }
+
+    // Get stream position.
+    inline std::size_t inpos(void) { return m_rr.stream().inpos(); }
+
+    // True if reached end of stream.
+    inline bool end(void) { return m_rr.stream().end(); }
+
+    // Get statistics collected so far.
+    // StatsPolicy must be collect_stats.
+    inline parse_stats stats(void) const { return m_rr.stats(); }
+
+    // Get underlying reader.
+    inline raw_reader_type& raw_reader(void) noexcept { return m_rr; }
+
+private:
+    friend class value_handle<ondemand_reader>;
+    friend class array_cursor<ondemand_reader>;
+    friend class object_cursor<ondemand_reader>;
+    template <typename, typename> friend class internal::cursor_iterator;
+
+    // Push a value, which is unread until used or skipped.
+    inline void start_value(void)
+    {
+        m_nodes.push({ DOCNODE_value });
+        m_serial++;
+    }
+
+    // Start using the value with serial. Throws if it
+    // was already used or skipped.
+    inline void use_value(std::size_t serial)
+    {
+        if (serial != m_serial || m_nodes.top().type != DOCNODE_value)
+            throw std::runtime_error("Value was already read or skipped.");
+        m_nodes.pop();
+    }
+
+    // Start reading object or array from the value with serial,
+    // which also identifies the container. Returns its depth.
+    inline std::size_t start_container(std::size_t serial, doc_node_t type)
+    {
+        use_value(serial);
+        if (type == DOCNODE_object)
+            m_rr.read_start_object();
+        else m_rr.read_start_array();
+
+        m_nodes.push({ type });
+        m_containers.reserve(m_nodes.size() - 1);
+        m_containers[m_nodes.size() - 2] = serial;
+        return m_nodes.size();
+    }
+
+    // Move to the next value in the container with serial at depth.
+    // Returns false if at the end of the container. Throws if
+    // the container already ended.
+    inline bool next(std::size_t depth, std::size_t serial)
+    {
+        if (m_nodes.size() < depth || m_containers[depth - 2] != serial)
+            throw std::runtime_error("Container was already read or skipped.");
+        return move_next(depth);
+    }
+
+    // Move to the next value in the container at depth.
+    // Returns false if at the end of the container.
+    inline bool move_next(std::size_t depth);
+
+    // Skip all nodes above depth.
+    inline void finish_nodes(std::size_t depth)
+    {
+        while (m_nodes.size() > depth)
+        {
+            if (m_nodes.top().type == DOCNODE_value)
+            {
+                m_rr.skip_value();
+                m_nodes.pop();
+            }
+            else
+            {   // skip the rest of the container
+                std::size_t top = m_nodes.size();
+                while (move_next(top)) {}
+            }
+        }
+    }
+
+private:
+    raw_reader_type m_rr;
+    internal::node_stack<AllocatorPolicy> m_nodes;
+    // Serials of the open containers, by depth - 2.
+    // Cleared to 0 when a container ends.
+    internal::buffer<std::size_t, iutil::rebind_alloc_t<AllocatorPolicy, std::size_t>> m_containers;
+    // Key of the current value, in objects.
+    string_view m_key;
+    // Incremented for every value, so that handles
+    // to earlier values can be detected. Starts at 1.
+    std::size_t m_serial;
+};
+
+
+// Handle to a value of an ondemand_reader.
+// The value is parsed when the handle is converted, and can
+// only be converted once. It becomes invalid once its cursor
+// moves on.
+template <typename Reader>
+class value_handle
+{
+public:
+    // Get type of value, without reading it.
+    inline token_t type(void) { return m_r->m_rr.token(); }
+
+    // Read value as T. Same as raw_ascii_reader::read<T>().
+    template <typename T>
+    inline T get(void)
+    {
+        m_r->use_value(m_serial);
+        return m_r->m_rr.template read<T>();
+    }
+
+    // Read string without copying if possible.
+    // The result is invalidated by the next read
+    // (see raw_ascii_reader::read_string_view()).
+    inline string_view get_string_view(void)
+    {
+        m_r->use_value(m_serial);
+        return m_r->m_rr.read_string_view();
+    }
+
+    // Start reading array.
+    inline array_cursor<Reader> get_array(void)
+    {
+        return { *m_r, m_r->start_container(m_serial, DOCNODE_array), m_serial };
+    }
+
+    // Start reading object.
+    inline object_cursor<Reader> get_object(void)
+    {
+        return { *m_r, m_r->start_container(m_serial, DOCNODE_object), m_serial };
+    }
+
+    // Skip value of any type. Only brackets, strings and
+    // escapes are tracked, so the value is not fully validated.
+    inline void skip(void)
+    {
+        m_r->use_value(m_serial);
+        m_r->m_rr.skip_value();
+    }
+
+private:
+    friend Reader;
+    friend class array_cursor<Reader>;
+    friend class object_cursor<Reader>;
+
+    value_handle(Reader& r, std::size_t serial) noexcept :
+        m_r(&r), m_serial(serial)
+    {}
+
+private:
+    Reader* m_r;
+    std::size_t m_serial;
+};
+
+
+namespace internal {
+
+// Single-pass iterator over a container of an ondemand_reader.
+// Deref is called with the reader to get the current element.
+template <typename Reader, typename Deref>
+class cursor_iterator
+{
+public:
+    using value_type = decltype(std::declval<Deref>()(std::declval<Reader&>()));
+
+    cursor_iterator(Reader* r, std::size_t depth, std::size_t serial, bool end) noexcept :
+        m_r(r), m_depth(depth), m_serial(serial), m_end(end)
+    {}
+
+    inline value_type operator*(void) const { return Deref{}(*m_r); }
+
+    inline cursor_iterator& operator++(void)
+    {
+        m_end = !m_r->next(m_depth, m_serial);
+        return *this;
+    }
+
+    inline bool operator==(const cursor_iterator& rhs) const noexcept { return m_end == rhs.m_end; }
+    inline bool operator!=(const cursor_iterator& rhs) const noexcept { return m_end != rhs.m_end; }
+
+private:
+    Reader* m_r;
+    std::size_t m_depth;
+    // Serial of the container.
+    std::size_t m_serial;
+    bool m_end;
+};
+
+}
+
+// Cursor over the values of an array.
+// Can only be iterated once. Range-for reads the array
+// to its end, skipping the values that are not used.
+template <typename Reader>
+class array_cursor
+{
+private:
+    struct deref
+    {
+        inline value_handle<Reader> operator()(Reader& r) const { return { r, r.m_serial }; }
+    };
+
+public:
+    using iterator = internal::cursor_iterator<Reader, deref>;
+
+    // Moves to the first value.
+    inline iterator begin(void) { return { m_r, m_depth, m_serial, !m_r->next(m_depth, m_serial) }; }
+    inline iterator end(void) { return { m_r, m_depth, m_serial, true }; }
+
+private:
+    friend class value_handle<Reader>;
+
+    array_cursor(Reader& r, std::size_t depth, std::size_t serial) noexcept :
+        m_r(&r), m_depth(depth), m_serial(serial)
+    {}
+
+private:
+    Reader* m_r;
+    std::size_t m_depth;
+    // Serial of the container.
+    std::size_t m_serial;
+};
+
+
+// Key-value pair of an object_cursor.
+template <typename Reader>
+class object_field
+{
+public:
+    // Key, unescaped. Invalidated when the value
+    // is read (see raw_ascii_reader::read_string_view()).
+    inline string_view key(void) const noexcept { return m_key; }
+
+    inline value_handle<Reader> value(void) const noexcept { return m_value; }
+
+private:
+    friend class object_cursor<Reader>;
+
+    object_field(string_view key, value_handle<Reader> value) noexcept :
+        m_key(key), m_value(value)
+    {}
+
+private:
+    string_view m_key;
+    value_handle<Reader> m_value;
+};
+
+// Cursor over the key-value pairs of an object.
+// Can only be iterated once. Range-for reads the object
+// to its end, skipping the values that are not used.
+template <typename Reader>
+class object_cursor
+{
+private:
+    struct deref
+    {
+        inline object_field<Reader> operator()(Reader& r) const { return { r.m_key, { r, r.m_serial } }; }
+    };
+
+public:
+    using iterator = internal::cursor_iterator<Reader, deref>;
+
+    // Moves to the first key-value pair.
+    inline iterator begin(void) { return { m_r, m_depth, m_serial, !m_r->next(m_depth, m_serial) }; }
+    inline iterator end(void) { return { m_r, m_depth, m_serial, true }; }
+
+private:
+    friend class value_handle<Reader>;
+
+    object_cursor(Reader& r, std::size_t depth, std::size_t serial) noexcept :
+        m_r(&r), m_depth(depth), m_serial(serial)
+    {}
+
+private:
+    Reader* m_r;
+    std::size_t m_depth;
+    // Serial of the container.
+    std::size_t m_serial;
+};
+
+
+
+template <typename Istream, typename AllocatorPolicy, typename StatsPolicy>
+inline bool ondemand_reader<Istream, AllocatorPolicy, StatsPolicy>::move_next(std::size_t depth)
+{
+    // skip unused value and any cursors left inside it
+    finish_nodes(depth);
+
+    internal::node_info& node = m_nodes.top();
+    bool is_object = node.type == DOCNODE_object;
+
+    if (m_rr.token() == (is_object ? TOKEN_end_object : TOKEN_end_array))
+    {
+        if (is_object)
+            m_rr.read_end_object();
+        else m_rr.read_end_array();
+
+        m_nodes.pop();
+        m_containers[depth - 2] = 0;
+        return false;
+    }
+
+    if (node.has_children)
+        m_rr.read_item_separator();
+    node.has_children = true;
+
+    if (is_object)
+    {
+        m_key = m_rr.read_string_view();
+        m_rr.read_key_separator();
+    }
+    start_value();
+    return true;
+}
+
+}
+
+#endif
@@ -0,0 +1,453 @@
+//
+// Multi-threaded parsing of in-memory input.
+//
+
+#ifndef SIJSON_PARALLEL_HPP
+#define SIJSON_PARALLEL_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "internal/util.hpp"
+#include "internal/simd.hpp"
+#include "internal/impl_index.hpp"
+
+#include "common.hpp"
+#include "memorystream.hpp"
+#include "reader.hpp"
+#include "ndjsonreader.hpp"
+
+
+namespace sijson {
+
+// Options for parallel parsing.
+struct parallel_options
+{
+    // Number of worker threads.
+    // If 0, std::thread::hardware_concurrency() is used.
+    std::size_t num_threads = 0;
+
+    // Approximate number of chars given to a thread at once.
+    std::size_t chunk_size = std::size_t(1) << 20;
+};
+
+namespace internal {
+
+// Get the end of the chunk starting at first. The chunk has
+// at least chunk_size chars and ends after a newline, or at last.
+inline const char* line_chunk_end(const char* first, const char* last, std::size_t chunk_size) noexcept
+{
+    if ((std::size_t)(last - first) <= chunk_size)
+        return last;
+
+    auto nl = (const char*)std::memchr(first + chunk_size, '\n', (std::size_t)(last - first) - chunk_size);
+    return nl ? nl + 1 : last;
+}
+
+// Splits input into chunks and processes them on a pool of
+// threads. Results are consumed on the calling thread, in order.
+// The number of chunks in flight is bounded, so memory use does
+// not depend on the input size.
+template <typename ChunkResult>
+class chunk_pipeline
+{
+public:
+    // Calls process(memspan<const char> chunk, std::size_t chunk_offset)
+    // for each chunk of [first, last) on worker threads, then consume(result)
+    // for each result on the calling thread. chunk_end(begin) gets the end
+    // of the chunk that starts at begin. If any call throws, the remaining
+    // chunks are not processed and the exception is rethrown.
+    template <typename ChunkEndFunc, typename ProcessFunc, typename ConsumeFunc>
+    static void run(const char* first, const char* last, const parallel_options& options,
+        ChunkEndFunc chunk_end, ProcessFunc process, ConsumeFunc consume)
+    {
+        chunk_pipeline p(first, last, options);
+        p.start(chunk_end, process);
+
+        std::exception_ptr error;
+        std::unique_lock<std::mutex> lock(p.m_mutex);
+        while (true)
+        {
+            p.m_cv.wait(lock, [&] { return p.front_ready() || p.all_consumed(); });
+            if (p.all_consumed())
+                break;
+
+            slot s = std::move(p.m_slots.front());
+            p.m_slots.pop_front();
+            p.m_consumed++;
+            p.m_cv.notify_all();
+            lock.unlock();
+
+            error = s.error;
+            if (!error)
+            {
+                try { consume(std::move(s.result)); }
+                catch (...) { error = std::current_exception(); }
+            }
+            lock.lock();
+            if (error)
+                break;
+        }
+        lock.unlock();
+
+        p.stop();
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    chunk_pipeline(const chunk_pipeline&) = delete;
+    chunk_pipeline& operator=(const chunk_pipeline&) = delete;
+
+    ~chunk_pipeline(void) { stop(); }
+
+private:
+    struct slot
+    {
+        ChunkResult result;
+        std::exception_ptr error;
+        bool ready = false;
+    };
+
+    chunk_pipeline(const char* first, const char* last, const parallel_options& options) :
+        m_first(first), m_next(first), m_last(last),
+        m_num_threads(options.num_threads != 0 ? options.num_threads :
+            std::max<std::size_t>(1, std::thread::hardware_concurrency())),
+        m_next_index(0), m_consumed(0), m_stopped(false)
+    {}
+
+    inline bool front_ready(void) const noexcept { return !m_slots.empty() && m_slots.front().ready; }
+    inline bool all_consumed(void) const noexcept { return m_slots.empty() && m_next == m_last; }
+
+    template <typename ChunkEndFunc, typename ProcessFunc>
+    inline void start(ChunkEndFunc chunk_end, ProcessFunc process)
+    {
+        const std::size_t max_in_flight = 4 * m_num_threads;
+
+        for (std::size_t i = 0; i < m_num_threads; ++i)
+        {
+            m_threads.emplace_back([this, chunk_end, process, max_in_flight] {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while (true)
+                {
+                    m_cv.wait(lock, [&] {
+                        return m_stopped || m_next == m_last ||
+                            m_next_index < m_consumed + max_in_flight;
+                    });
+                    if (m_stopped || m_next == m_last)
+                        return;
+
+                    const char* begin = m_next;
+                    const char* end = chunk_end(begin);
+                    m_next = end;
+                    std::size_t index = m_next_index++;
+                    m_slots.emplace_back();
+                    lock.unlock();
+
+                    ChunkResult result;
+                    std::exception_ptr error;
+                    try { result = process(memspan<const char>(begin, end), (std::size_t)(begin - m_first)); }
+                    catch (...) { error = std::current_exception(); }
+
+                    lock.lock();
+                    slot& s = m_slots[index - m_consumed];
+                    s.result = std::move(result);
+                    s.error = error;
+                    s.ready = true;
+                    m_cv.notify_all();
+                }
+            });
+        }
+    }
+
+    inline void stop(void) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_cv.notify_all();
+        for (auto& t : m_threads)
+            if (t.joinable()) t.join();
+    }
+
+private:
+    const char* m_first;
+    const char* m_next;
+    const char* m_last;
+    std::size_t m_num_threads;
+    std::size_t m_next_index;
+    std::size_t m_consumed;
+    bool m_stopped;
+
+    std::deque<slot> m_slots; // m_slots[i] has chunk (m_consumed + i)
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
+
+// Unused chunk result.
+struct no_result {};
+
+template <typename Istream>
+inline memspan<const char> remaining_input(Istream& stream)
+{
+    static_assert(iutil::has_contiguous_input<Istream>::value,
+        "Istream must be an in-memory stream (e.g. imstream, immapstream).");
+
+    auto data = stream.indata();
+    return { data.begin + stream.inpos(), data.end };
+}
+
+// Skip the value at the start of [first, last) and any whitespace
+// after it. Returns the first char after them. Only the extent
+// of the value is checked (see raw_ascii_reader::skip_value()).
+inline const char* skip_element(const char* first, const char* last)
+{
+    imstream is(first, (std::size_t)(last - first));
+    raw_ascii_reader<imstream> reader(is);
+    reader.skip_value();
+    return simd::find_non_ws(first + is.inpos(), last);
+}
+
+// Parse the elements of the array at the start of stream in parallel.
+// element(ChunkResult& result, ascii_reader<imstream>& reader, std::size_t offset)
+// is called for each element on a worker thread, then consume(ChunkResult&& result)
+// for each chunk of elements on the calling thread, in order.
+template <typename ChunkResult, typename Istream, typename ElementFunc, typename ConsumeFunc>
+inline void parallel_array(Istream& stream, const parallel_options& options,
+    ElementFunc element, ConsumeFunc consume)
+{
+    auto input = remaining_input(stream);
+    std::size_t base = stream.inpos();
+    auto pos = [&](const char* p) { return base + (std::size_t)(p - input.begin); };
+
+    const char* first = simd::find_non_ws(input.begin, input.end);
+    if (first == input.end || *first != '[')
+        throw iutil::parse_error_exp(pos(first), "'['");
+
+    const char* elems = simd::find_non_ws(first + 1, input.end);
+    if (elems != input.end && *elems == ']')
+    {
+        stream.advance((std::size_t)(elems + 1 - input.begin));
+        return;
+    }
+
+    // Chunks are found with a single scanner, since each
+    // chunk begins where the last one ended. The end of the
+    // array is the end of the last chunk.
+    array_scanner scanner(first + 1, input.end);
+    const char* array_end = nullptr;
+
+    chunk_pipeline<ChunkResult>::run(first + 1, input.end, options,
+        [&](const char* begin)
+        {
+            const char* min_end = (std::size_t)(input.end - begin) > options.chunk_size ?
+                begin + options.chunk_size : input.end;
+
+            const char* sep;
+            do { sep = scanner.next(); } while (sep < min_end && *sep == ',');
+
+            if (sep != input.end && *sep == ',')
+                return sep + 1;
+            if (sep != input.end)
+                array_end = sep;
+            return input.end;
+        },
+        [&](memspan<const char> chunk, std::size_t)
+        {
+            ChunkResult result;
+            array_scanner elements(chunk.begin, chunk.end);
+
+            const char* elem = chunk.begin;
+            while (elem != chunk.end)
+            {
+                const char* sep = elements.next();
+                const char* value = simd::find_non_ws(elem, sep);
+                if (value == sep)
+                    throw iutil::parse_error_exp(pos(value), "value");
+                if (sep == chunk.end || (*sep != ',' && *sep != ']'))
+                    throw iutil::parse_error_exp(pos(sep), "',' or ']'");
+
+                imstream is(value, (std::size_t)(sep - value));
+                ascii_reader<imstream> reader(is);
+                element(result, reader, pos(value));
+
+                // each element must be a single value. If element()
+                // did not read to its end, skip it to check
+                const char* rest = simd::find_non_ws(value + is.inpos(), sep);
+                if (rest != sep)
+                    rest = skip_element(value, sep);
+                if (rest != sep)
+                    throw iutil::parse_error_exp(pos(rest), "',' or ']'");
+
+                if (*sep == ']')
+                    break;
+                elem = sep + 1;
+            }
+            return result;
+        },
+        consume);
+
+    // trailing comma at the end of input
+    if (!array_end)
+        throw iutil::parse_error_exp(pos(input.end), "value");
+
+    stream.advance((std::size_t)(array_end + 1 - input.begin));
+}
+}
+
+// Reader passed to the callbacks of parallel_ndjson_for_each()
+// and parallel_ndjson_transform().
+using parallel_ndjson_reader = ndjson_reader<imstream>::reader_type;
+
+
+// Parse newline-delimited JSON in parallel.
+// Istream must be an in-memory stream (e.g. imstream, immapstream).
+//
+// The input is split at newlines into chunks, which are parsed on a pool
+// of threads. func(parallel_ndjson_reader& reader, std::size_t offset) is
+// called for each record on a worker thread, in no particular order.
+// offset is the stream position of the record. The reader is positioned at
+// the start of the record and cannot read past its line.
+//
+// If func throws, parsing stops and the exception is rethrown.
+// Catch exceptions in func to skip malformed records instead.
+// On return, the stream is at the end of the input.
+//
+template <typename Istream, typename Func>
+inline void parallel_ndjson_for_each(Istream& stream, Func func,
+    const parallel_options& options = parallel_options())
+{
+    auto input = internal::remaining_input(stream);
+    std::size_t base = stream.inpos();
+
+    internal::chunk_pipeline<internal::no_result>::run(input.begin, input.end, options,
+        [&](const char* begin) { return internal::line_chunk_end(begin, input.end, options.chunk_size); },
+        [&](memspan<const char> chunk, std::size_t chunk_offset)
+        {
+            imstream is(chunk);
+            ndjson_reader<imstream> nd(is);
+            while (nd.next_record())
+                func(nd.reader(), base + chunk_offset + nd.record_offset());
+
+            return internal::no_result();
+        },
+        [](internal::no_result&&) {});
+
+    stream.advance(input.size());
+}
+
+// Parse newline-delimited JSON in parallel, keeping record order.
+// Istream must be an in-memory stream (e.g. imstream, immapstream).
+//
+// parse(parallel_ndjson_reader& reader, std::size_t offset) is called for
+// each record on a worker thread (see parallel_ndjson_for_each()). The value
+// it returns is passed to consume() on the calling thread, in record order.
+//
+// If parse or consume throws, parsing stops and the exception is rethrown.
+// On return, the stream is at the end of the input.
+//
+template <typename Istream, typename ParseFunc, typename ConsumeFunc>
+inline void parallel_ndjson_transform(Istream& stream, ParseFunc parse, ConsumeFunc consume,
+    const parallel_options& options = parallel_options())
+{
+    using result_type = typename std::decay<decltype(
+        parse(std::declval<parallel_ndjson_reader&>(), std::size_t()))>::type;
+
+    auto input = internal::remaining_input(stream);
+    std::size_t base = stream.inpos();
+
+    internal::chunk_pipeline<std::vector<result_type>>::run(input.begin, input.end, options,
+        [&](const char* begin) { return internal::line_chunk_end(begin, input.end, options.chunk_size); },
+        [&](memspan<const char> chunk, std::size_t chunk_offset)
+        {
+            std::vector<result_type> results;
+
+            imstream is(chunk);
+            ndjson_reader<imstream> nd(is);
+            while (nd.next_record())
+                results.push_back(parse(nd.reader(), base + chunk_offset + nd.record_offset()));
+
+            return results;
+        },
+        [&](std::vector<result_type>&& results)
+        {
+            for (auto&& result : results)
+                consume(std::move(result));
+        });
+
+    stream.advance(input.size());
+}
+
+
+// Reader passed to the callbacks of parallel_array_for_each()
+// and parallel_array_transform().
+using parallel_array_reader = ascii_reader<imstream>;
+
+
+// Parse the elements of a JSON array in parallel.
+// Istream must be an in-memory stream (e.g. imstream, immapstream),
+// positioned at the array.
+//
+// A pre-scan finds the boundaries of the elements (skipping strings
+// and nested values). Chunks of elements are then parsed on a pool of
+// threads. func(parallel_array_reader& reader, std::size_t offset) is
+// called for each element on a worker thread, in no particular order.
+// offset is the stream position of the element. The reader is positioned
+// at the start of the element and cannot read past its end. Any part of
+// the element that func does not read is skipped, and it is an error if
+// more than one value is found before the next ',' or ']'.
+//
+// If func throws, parsing stops and the exception is rethrown.
+// On return, the stream is after the end of the array.
+//
+template <typename Istream, typename Func>
+inline void parallel_array_for_each(Istream& stream, Func func,
+    const parallel_options& options = parallel_options())
+{
+    internal::parallel_array<internal::no_result>(stream, options,
+        [&](internal::no_result&, parallel_array_reader& reader, std::size_t offset)
+        { func(reader, offset); },
+        [](internal::no_result&&) {});
+}
+
+// Parse the elements of a JSON array in parallel, keeping element order.
+// Istream must be an in-memory stream (e.g. imstream, immapstream),
+// positioned at the array.
+//
+// parse(parallel_array_reader& reader, std::size_t offset) is called for
+// each element on a worker thread (see parallel_array_for_each()). The value
+// it returns is passed to consume() on the calling thread, in element order.
+//
+// If parse or consume throws, parsing stops and the exception is rethrown.
+// On return, the stream is after the end of the array.
+//
+template <typename Istream, typename ParseFunc, typename ConsumeFunc>
+inline void parallel_array_transform(Istream& stream, ParseFunc parse, ConsumeFunc consume,
+    const parallel_options& options = parallel_options())
+{
+    using result_type = typename std::decay<decltype(
+        parse(std::declval<parallel_array_reader&>(), std::size_t()))>::type;
+
+    internal::parallel_array<std::vector<result_type>>(stream, options,
+        [&](std::vector<result_type>& results, parallel_array_reader& reader, std::size_t offset)
+        { results.push_back(parse(reader, offset)); },
+        [&](std::vector<result_type>&& results)
+        {
+            for (auto&& result : results)
+                consume(std::move(result));
+        });
+}
+
+}
+
+#endif
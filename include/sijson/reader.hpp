@@ -4,6 +4,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <cassert>
 #include <memory>
 #include <type_traits>
@@ -18,22 +19,29 @@
 #include "internal/util.hpp"
 #include "internal/buffers.hpp"
 #include "internal/impl_rw.hpp"
+#include "internal/impl_charconv.hpp"
 
 #include "common.hpp"
 #include "number.hpp"
 #include "stringstream.hpp"
 #include "stdstream.hpp"
+#include "stats.hpp"
+#include "keyset.hpp"
 
 
 namespace sijson {
 
 // Low-level ASCII JSON reader.
-template <typename Istream>
+template <typename Istream,
+    // Statistics to collect (no_stats or collect_stats).
+    typename StatsPolicy = no_stats>
 class raw_ascii_reader
 {
 private:
     using JsonIstream = wrap_std_istream_t<Istream>;
 
+    template <typename, typename, typename> friend class ascii_reader;
+
 public:
     using stream_type = JsonIstream;
 
@@ -79,8 +87,10 @@ public:
         typename Allocator = std::allocator<char>>
         inline std::basic_string<char, Traits, Allocator> read_string(void)
     {
+        skip_counted_ws();
         basic_ostdsstream<Traits, Allocator> os;
         read_string_impl(m_stream, os);
+        if (StatsPolicy::enabled) count_string(os.outpos());
         return std::move(os).str();
     }
 
@@ -96,6 +106,19 @@ public:
         return read_string<typename DestString::traits_type, typename DestString::allocator_type>();
     }
 
+    // Read string without copying if possible. String is unescaped.
+    // If the stream has contiguous input (e.g. imstream) and the string
+    // has no escapes, the result points into the stream's data. Otherwise
+    // it points into a buffer owned by the reader, which is overwritten
+    // by the next call, or by reading a number over 128 chars long.
+    inline string_view read_string_view(void)
+    {
+        skip_counted_ws();
+        auto str = read_string_view_impl(m_stream, m_scratch, iutil::has_contiguous_input<JsonIstream>{});
+        if (StatsPolicy::enabled) count_string(str.size());
+        return str;
+    }
+
     // Read string into output stream.
     // String is unescaped.
     // If quoted is false, quotes are not
@@ -108,10 +131,12 @@ public:
     // TOKEN_string. If token is null, reads it and returns TOKEN_null.
     // String is unescaped.
     template <typename Func>
-    inline token_t read_string_or_null(Func get_os)
-    {
-        return read_string_or_null_impl(m_stream, get_os) ? TOKEN_string : TOKEN_null;
-    }
+    inline token_t read_string_or_null(Func get_os);
+
+    // Skip value of any type, including objects and arrays.
+    // Only brackets, strings and escapes are tracked, so the
+    // value is not fully validated.
+    inline void skip_value(void);
 
     // Read value of type T.
     // 
@@ -128,10 +153,71 @@ public:
     // Get stream.
     inline stream_type& stream(void) noexcept { return m_stream; }
 
+    // Get statistics collected so far.
+    // StatsPolicy must be collect_stats.
+    inline parse_stats stats(void) const
+    {
+        static_assert(StatsPolicy::enabled, "Stats are not collected (see StatsPolicy).");
+
+        parse_stats stats = m_stats.stats();
+        stats.refills = internal::refill_count(m_stream, internal::has_refill_count<JsonIstream>{});
+        return stats;
+    }
+
 private:
-    template <typename Ostream>
-    static inline void take_numstr(JsonIstream& is, Ostream& os);
+    // Skip whitespace before a token.
+    inline bool skip_ws(void) { return m_stats.skip_ws(m_stream); }
+
+    inline bool skip_ws(std::size_t& out_pos)
+    {
+        bool rval = skip_ws();
+        out_pos = m_stream.inpos();
+        return rval;
+    }
 
+    // Skip whitespace before a token, if it is counted. Used before
+    // static functions that skip whitespace themselves.
+    inline void skip_counted_ws(void) { if (StatsPolicy::enabled) skip_ws(); }
+
+    inline void count_string(std::size_t length)
+    {
+        m_stats.count_token(TOKEN_string);
+        m_stats.count_string(length);
+    }
+
+    inline void count_number(number::type_t type)
+    {
+        m_stats.count_token(TOKEN_number);
+        m_stats.count_number(type);
+    }
+
+    inline void count_structural(char c);
+
+    // Count a skipped value by its first char.
+    // Invalid chars are not counted.
+    inline void count_skipped(char c) noexcept;
+
+    // Size of buffer for numbers that cannot be referenced in the stream.
+    // Longer numbers are copied to the scratch stream.
+    static constexpr std::size_t NUMSTR_BUFSIZE = 128;
+
+    static inline bool is_numstr_end(char c) noexcept
+    {
+        return iutil::is_ws(c) || c == ',' || c == ']' || c == '}';
+    }
+
+    static inline memspan<const char> take_long_numstr(JsonIstream& is, basic_ostdsstream<>& scratch);
+    static inline memspan<const char> take_numstr(JsonIstream& is, char* buf, std::size_t bufsize,
+        basic_ostdsstream<>& scratch, std::false_type);
+    static inline memspan<const char> take_numstr(JsonIstream& is, char* buf, std::size_t bufsize,
+        basic_ostdsstream<>& scratch, std::true_type);
+    template <std::size_t N>
+    static inline memspan<const char> take_numstr(JsonIstream& is, char(&buf)[N], basic_ostdsstream<>& scratch);
+
+    template <typename UintT>
+    static inline bool read_uintg_impl(JsonIstream& stream, UintT& out_value, std::false_type);
+    template <typename UintT>
+    static inline bool read_uintg_impl(JsonIstream& stream, UintT& out_value, std::true_type);
     template <typename UintT>
     static inline bool read_uintg_impl(JsonIstream& stream, UintT& out_value);
     template <typename IntT, IntT lbound, IntT ubound>
@@ -139,17 +225,33 @@ private:
     template <typename IntT>
     static inline bool read_intg_impl(JsonIstream& stream, IntT& out_value);
 
-    template <bool CheckNanInfHex = true, typename Osstream, typename FloatT>
-    static inline bool read_floating_impl(Osstream& numstr, FloatT& out_value);
-    static inline bool read_number_impl(JsonIstream& stream, number& out_value);
+    static inline bool read_number_impl(JsonIstream& stream, basic_ostdsstream<>& scratch, number& out_value);
 
     template <typename Ostream>
     static inline void take_unescape(JsonIstream& is, Ostream& os);
 
+    template <bool Quoted, typename Ostream>
+    static inline void take_unescape_all(JsonIstream& is, Ostream& os, std::false_type);
+    template <bool Quoted, typename Ostream>
+    static inline void take_unescape_all(JsonIstream& is, Ostream& os, std::true_type);
+    template <bool Quoted, typename Ostream>
+    static inline void take_unescape_all(JsonIstream& is, Ostream& os);
+
+    static inline bool skip_string_body(JsonIstream& is, std::false_type);
+    static inline bool skip_string_body(JsonIstream& is, std::true_type);
+    static inline bool skip_nested(JsonIstream& is, std::false_type);
+    static inline bool skip_nested(JsonIstream& is, std::true_type);
+
     template <typename Ostream>
     static inline void read_string_impl(JsonIstream& is, Ostream& os);
     template <typename Func>
     static inline bool read_string_or_null_impl(JsonIstream& is, Func get_os);
+    template <typename Func>
+    inline token_t read_string_or_null(Func get_os, std::false_type);
+    template <typename Func>
+    inline token_t read_string_or_null(Func get_os, std::true_type);
+    static inline string_view read_string_view_impl(JsonIstream& is, basic_ostdsstream<>& scratch, std::false_type);
+    static inline string_view read_string_view_impl(JsonIstream& is, basic_ostdsstream<>& scratch, std::true_type);
 
     template <typename IntT>
     inline IntT read_intg_t(void);
@@ -194,6 +296,9 @@ private:
 
 private:
     wrap_std_istream_t<Istream&> m_stream;
+    // Unescaped strings for read_string_view().
+    basic_ostdsstream<> m_scratch;
+    StatsPolicy m_stats;
 };
 
 
@@ -201,7 +306,9 @@ private:
 // ASCII JSON reader.
 template <typename Istream,
     // Allocator type used for internal purposes/book-keeping.
-    typename AllocatorPolicy = std::allocator<void>>
+    typename AllocatorPolicy = std::allocator<void>,
+    // Statistics to collect (no_stats or collect_stats).
+    typename StatsPolicy = no_stats>
 class ascii_reader : public internal::rw_base<AllocatorPolicy>
 {
 public:
@@ -276,6 +383,21 @@ public:
         return read_key<typename DestString::traits_type, typename DestString::allocator_type>();
     }
 
+    // Read object key without copying if possible.
+    // String is unescaped. The result is invalidated by the next read
+    // (see raw_ascii_reader::read_string_view()).
+    inline string_view read_key_view(void)
+    {
+        this->template assert_rule<DOCNODE_key>();
+
+        read_separator();
+        auto key = m_rr.read_string_view();
+
+        this->m_nodes.push({ DOCNODE_key });
+        // don't end_child_node(), key-value pair is incomplete
+        return key;
+    }
+
     // Read object key.
     // Throws if key (after unescaping) does not match expected_key.
     template <typename Traits, typename Allocator>
@@ -289,6 +411,17 @@ public:
     // Throws if key (after unescaping) does not match expected_key.
     void read_key(const char* expected_key, std::size_t length);
 
+    // Read object key and find it in keys, without copying it.
+    // Returns its index in keys, or key_set::npos if not found
+    // (the value can then be skipped with skip_value()).
+    inline std::size_t read_key_index(const key_set& keys)
+    {
+        internal::keyset_ostream os(keys);
+        std::size_t startpos;
+        read_key_impl(os, startpos);
+        return os.index();
+    }
+
     // Read value.
     template <typename Value>
     Value read_value(void);
@@ -300,6 +433,33 @@ public:
         out_value = read_value<Value>();
     }
 
+    // Read string value without copying if possible.
+    // String is unescaped. The result is invalidated by the next read
+    // (see raw_ascii_reader::read_string_view()).
+    inline string_view read_string_view(void)
+    {
+        this->template assert_rule<DOCNODE_value>();
+
+        read_separator();
+        auto str = m_rr.read_string_view();
+
+        this->end_child_node();
+        return str;
+    }
+
+    // Skip value of any type, including objects and arrays.
+    // Only brackets, strings and escapes are tracked, so the
+    // value is not fully validated.
+    inline void skip_value(void)
+    {
+        this->template assert_rule<DOCNODE_value>();
+
+        read_separator();
+        m_rr.skip_value();
+
+        this->end_child_node();
+    }
+
     // Read object key-value pair.
     // Key must be a std::basic_string.
     template <typename Key, typename Value>
@@ -345,24 +505,40 @@ public:
     // True if reached end of stream.
     inline bool end(void) { return m_rr.stream().end(); }
 
+    // Get statistics collected so far.
+    // StatsPolicy must be collect_stats.
+    inline parse_stats stats(void) const { return m_rr.stats(); }
+
+    // Start reading a new document from the current
+    // stream position. Internal buffers are reused.
+    inline void reset(void)
+    {
+        this->m_nodes.clear();
+        this->m_nodes.push({ DOCNODE_root });
+    }
+
 private:
     inline void read_separator(void);
 
+    template <typename Ostream>
+    inline void read_key_impl(Ostream& os, std::size_t& out_pos);
+
     template <typename Traits, typename IsEndpFunc>
     inline bool read_key_impl(const char* str, IsEndpFunc is_endp, std::size_t& out_pos);
 
 private:
-    raw_ascii_reader<Istream> m_rr;
+    raw_ascii_reader<Istream, StatsPolicy> m_rr;
 };
 
 
 
-template <typename Istream>
-inline void raw_ascii_reader<Istream>::read_char(char expected)
+template <typename Istream, typename StatsPolicy>
+inline void raw_ascii_reader<Istream, StatsPolicy>::read_char(char expected)
 {
-    if (!iutil::skip_ws(m_stream)) goto fail;
+    if (!skip_ws()) goto fail;
     if (m_stream.peek() != expected) goto fail;
     m_stream.take();
+    if (StatsPolicy::enabled) count_structural(expected);
     return;
 fail:
     throw iutil::parse_error_exp(m_stream.inpos(),
@@ -370,10 +546,10 @@ fail:
 }
 
 // Get type of token to be read.
-template <typename Istream>
-inline token_t raw_ascii_reader<Istream>::token(void)
+template <typename Istream, typename StatsPolicy>
+inline token_t raw_ascii_reader<Istream, StatsPolicy>::token(void)
 {
-    if (!iutil::skip_ws(m_stream))
+    if (!skip_ws())
         return TOKEN_eof;
 
     switch (m_stream.peek())
@@ -397,28 +573,107 @@ inline token_t raw_ascii_reader<Istream>::token(void)
     throw iutil::parse_error_exp(m_stream.inpos(), "token");
 }
 
-template <typename Istream>
+template <typename Istream, typename StatsPolicy>
+inline void raw_ascii_reader<Istream, StatsPolicy>::count_structural(char c)
+{
+    switch (c)
+    {
+        case '{':
+            m_stats.count_token(TOKEN_begin_object);
+            m_stats.start_node();
+            break;
+        case '[':
+            m_stats.count_token(TOKEN_begin_array);
+            m_stats.start_node();
+            break;
+        case '}':
+            m_stats.count_token(TOKEN_end_object);
+            m_stats.end_node();
+            break;
+        case ']':
+            m_stats.count_token(TOKEN_end_array);
+            m_stats.end_node();
+            break;
+        case ':': m_stats.count_token(TOKEN_key_separator); break;
+        case ',': m_stats.count_token(TOKEN_item_separator); break;
+        default: assert(false); break;
+    }
+}
+
+template <typename Istream, typename StatsPolicy>
+inline void raw_ascii_reader<Istream, StatsPolicy>::count_skipped(char c) noexcept
+{
+    switch (c)
+    {
+        case '{': m_stats.count_token(TOKEN_begin_object); break;
+        case '[': m_stats.count_token(TOKEN_begin_array); break;
+        case '"': m_stats.count_token(TOKEN_string); break;
+        case 't':
+        case 'f': m_stats.count_token(TOKEN_boolean); break;
+        case 'n': m_stats.count_token(TOKEN_null); break;
+        case '-': m_stats.count_token(TOKEN_number); break;
+        default:
+            if (iutil::is_digit(c))
+                m_stats.count_token(TOKEN_number);
+            break;
+    }
+}
+
+template <typename Istream, typename StatsPolicy>
 template <typename UintT>
-inline bool raw_ascii_reader<Istream>::read_uintg_impl(JsonIstream& stream, UintT& out_value)
+inline bool raw_ascii_reader<Istream, StatsPolicy>::read_uintg_impl(JsonIstream& stream, UintT& out_value, std::false_type)
 {
-    if (stream.end() || !iutil::is_digit(stream.peek())
-        || stream.peek() == '-')
+    if (stream.end() || !iutil::is_digit(stream.peek()))
         return false;
 
+    // no leading zeros
+    if (stream.peek() == '0')
+    {
+        stream.take();
+        out_value = 0;
+        return stream.end() || !iutil::is_digit(stream.peek());
+    }
+
     out_value = 0;
     while (!stream.end() && iutil::is_digit(stream.peek())) 
     {
-        UintT old = out_value;
-        out_value = 10 * out_value + (stream.peek() - '0');
-        if (out_value < old) return false; // overflow
+        auto digit = (unsigned)(stream.peek() - '0');
+        if (out_value > (std::numeric_limits<UintT>::max() - digit) / 10)
+            return false; // overflow
+        out_value = (UintT)(10 * out_value + digit);
         stream.take();
     }
     return true;
 }
 
-template <typename Istream>
+template <typename Istream, typename StatsPolicy>
+template <typename UintT>
+inline bool raw_ascii_reader<Istream, StatsPolicy>::read_uintg_impl(JsonIstream& stream, UintT& out_value, std::true_type)
+{
+    auto window = stream.window();
+    const char* end = window.begin;
+
+    if (!internal::charconv::parse_uint(end, window.end, out_value))
+        return false;
+
+    // number may continue past the window
+    if (end == window.end && !iutil::has_contiguous_input<JsonIstream>::value)
+        return read_uintg_impl(stream, out_value, std::false_type{});
+
+    stream.advance((std::size_t)(end - window.begin));
+    return true;
+}
+
+template <typename Istream, typename StatsPolicy>
+template <typename UintT>
+inline bool raw_ascii_reader<Istream, StatsPolicy>::read_uintg_impl(JsonIstream& stream, UintT& out_value)
+{
+    return read_uintg_impl(stream, out_value, iutil::has_input_window<JsonIstream>{});
+}
+
+template <typename Istream, typename StatsPolicy>
 template <typename IntT, IntT lbound, IntT ubound>
-inline bool raw_ascii_reader<Istream>::read_intg_impl(JsonIstream& stream, IntT& out_value)
+inline bool raw_ascii_reader<Istream, StatsPolicy>::read_intg_impl(JsonIstream& stream, IntT& out_value)
 {
     bool neg = stream.peek() == '-';
     if (neg) stream.take();
@@ -433,149 +688,185 @@ inline bool raw_ascii_reader<Istream>::read_intg_impl(JsonIstream& stream, IntT&
     return true;
 }
 
-template <typename Istream>
+template <typename Istream, typename StatsPolicy>
 template <typename IntT>
-inline bool raw_ascii_reader<Istream>::read_intg_impl(JsonIstream& stream, IntT& out_value)
+inline bool raw_ascii_reader<Istream, StatsPolicy>::read_intg_impl(JsonIstream& stream, IntT& out_value)
 {
     return read_intg_impl<IntT,
         std::numeric_limits<IntT>::min(),
         std::numeric_limits<IntT>::max()>(stream, out_value);
 }
 
-template <typename Istream>
+template <typename Istream, typename StatsPolicy>
 template <typename IntT>
-inline IntT raw_ascii_reader<Istream>::read_intg_t(void)
+inline IntT raw_ascii_reader<Istream, StatsPolicy>::read_intg_t(void)
 {
     IntT value;
-    if (!iutil::skip_ws(m_stream)) goto fail;
+    if (!skip_ws()) goto fail;
     if (!read_intg_impl(m_stream, value)) goto fail;
+    if (StatsPolicy::enabled) count_number(number::TYPE_intmax_t);
     return value;
 fail:
     throw iutil::parse_error_exp(m_stream.inpos(), "signed integral type");
 }
 
-template <typename Istream>
+template <typename Istream, typename StatsPolicy>
 template <typename UintT>
-inline UintT raw_ascii_reader<Istream>::read_uintg_t(void)
+inline UintT raw_ascii_reader<Istream, StatsPolicy>::read_uintg_t(void)
 {
     UintT value;
-    if (!iutil::skip_ws(m_stream)) goto fail;
+    if (!skip_ws()) goto fail;
     if (!read_uintg_impl(m_stream, value)) goto fail;
+    if (StatsPolicy::enabled) count_number(number::TYPE_uintmax_t);
     return value;
 fail:
     throw iutil::parse_error_exp(m_stream.inpos(), "unsigned integral type");
 }
 
-template <typename Istream>
+template <typename Istream, typename StatsPolicy>
 template <typename IntLeastT>
-inline IntLeastT raw_ascii_reader<Istream>::read_int_lst(const char* type_label)
+inline IntLeastT raw_ascii_reader<Istream, StatsPolicy>::read_int_lst(const char* type_label)
 {   
-    if (!iutil::skip_ws(m_stream)) goto fail;
+    if (!skip_ws()) goto fail;
 
     IntLeastT value;
     if (!read_intg_impl<IntLeastT,
         iutil::least_t_exp_min<IntLeastT>::value,
         iutil::least_t_exp_max<IntLeastT>::value>(m_stream, value)) goto fail;
+    if (StatsPolicy::enabled) count_number(number::TYPE_intmax_t);
     return value;
 fail:
     throw iutil::parse_error_exp(m_stream.inpos(), type_label);
 }
 
-template <typename Istream>
+template <typename Istream, typename StatsPolicy>
 template <typename UintLeastT>
-inline UintLeastT raw_ascii_reader<Istream>::read_uint_lst(const char* type_label)
+inline UintLeastT raw_ascii_reader<Istream, StatsPolicy>::read_uint_lst(const char* type_label)
 {
-    if (!iutil::skip_ws(m_stream)) goto fail;
+    if (!skip_ws()) goto fail;
 
     UintLeastT value;      
     if (!read_uintg_impl(m_stream, value)) goto fail;
     if (value > iutil::least_t_exp_max<UintLeastT>::value) goto fail;
+    if (StatsPolicy::enabled) count_number(number::TYPE_uintmax_t);
     return value;
 fail:
     throw iutil::parse_error_exp(m_stream.inpos(), type_label);
 }
 
-template <typename Istream>
-template <typename Ostream>
-inline void raw_ascii_reader<Istream>::take_numstr(JsonIstream& is, Ostream& os)
+// Take the rest of a number that did not fit in the
+// buffer, appending it to scratch. Returns all of scratch.
+template <typename Istream, typename StatsPolicy>
+inline memspan<const char> raw_ascii_reader<Istream, StatsPolicy>::take_long_numstr(
+    JsonIstream& is, basic_ostdsstream<>& scratch)
+{
+    while (!is.end() && !is_numstr_end(is.peek()))
+        scratch.put(is.take());
+
+    auto str = scratch.outdata();
+    return { str.begin, str.end };
+}
+
+template <typename Istream, typename StatsPolicy>
+inline memspan<const char> raw_ascii_reader<Istream, StatsPolicy>::take_numstr(
+    JsonIstream& is, char* buf, std::size_t bufsize, basic_ostdsstream<>& scratch, std::false_type)
 {
-    while (!is.end() && !iutil::is_ws(is.peek()))
+    std::size_t len = 0;
+    while (!is.end() && !is_numstr_end(is.peek()))
     {
-        switch (is.peek())
-        {
-            case ',': case']': case '}':
-                return;
-            default: os.put(is.take());
-                break;
+        if (len == bufsize)
+        {   // too long
+            scratch.clear();
+            scratch.putn(buf, len);
+            return take_long_numstr(is, scratch);
         }
+        buf[len++] = is.take();
     }
+    return { buf, buf + len };
 }
 
-template <typename Istream>
-template <bool CheckNanInfHex, typename Osstream, typename FloatT>
-inline bool raw_ascii_reader<Istream>::read_floating_impl(Osstream& numstream, FloatT& out_value)
+template <typename Istream, typename StatsPolicy>
+inline memspan<const char> raw_ascii_reader<Istream, StatsPolicy>::take_numstr(
+    JsonIstream& is, char* buf, std::size_t bufsize, basic_ostdsstream<>& scratch, std::true_type)
 {
-    if (numstream.outpos() == 0)
-        return false;
-
-    auto strdata = numstream.outdata();
-    auto str_begin = strdata.begin;
-    auto str_end = strdata.end;
+    auto window = is.window();
+    const char* end = window.begin;
+    while (end != window.end && !is_numstr_end(*end))
+        end++;
+
+    // window is not invalidated if advance() does
+    // not exhaust it, or if the input is contiguous
+    if (end != window.end || iutil::has_contiguous_input<JsonIstream>::value)
+    {
+        is.advance((std::size_t)(end - window.begin));
+        return { window.begin, end };
+    }
 
-    bool neg = false;
-    if (CheckNanInfHex)
+    // number may continue past the window
+    std::size_t len = 0;
+    while (true)
     {
-        // skip '-'
-        if (*str_begin == '-') {
-            neg = true; str_begin++;
-            if (numstream.outpos() == 1)
-                return false;
+        auto count = (std::size_t)(end - window.begin);
+        if (count > bufsize - len)
+        {   // too long
+            scratch.clear();
+            scratch.putn(buf, len);
+            scratch.putn(window.begin, count);
+            is.advance(count);
+            return take_long_numstr(is, scratch);
         }
 
-        auto is_ci_equal = [](char lhs, char rhs) {
-            return rhs == iutil::to_lower(lhs);
-        };
-        if (iutil::starts_with(str_begin, str_end, "0x", is_ci_equal) ||
-            iutil::starts_with(str_begin, str_end, "nan", is_ci_equal) ||
-            iutil::starts_with(str_begin, str_end, "inf", is_ci_equal))
-            return false;
-    }
-
-    internal::memspanbuf streambuf(str_begin,
-        (std::streamsize)(str_end - str_begin), std::ios_base::in);
-    std::istream sstream(&streambuf);
-    sstream.imbue(std::locale::classic()); // make decimal point '.'
-    sstream.precision(std::numeric_limits<FloatT>::max_digits10);
-    sstream >> out_value;
+        std::memcpy(buf + len, window.begin, count);
+        len += count;
+        is.advance(count);
+        if (end != window.end)
+            break;
 
-    if (CheckNanInfHex && neg)
-        out_value *= (FloatT)(-1);
+        window = is.window();
+        end = window.begin;
+        if (end == window.end)
+            break;
+        while (end != window.end && !is_numstr_end(*end))
+            end++;
+    }
+    return { buf, buf + len };
+}
 
-    return !sstream.fail();
+// Take the chars of a number and get a span over them.
+// If the number cannot be referenced directly in the stream,
+// it is copied to buf, or to scratch if it is too large for buf.
+template <typename Istream, typename StatsPolicy>
+template <std::size_t N>
+inline memspan<const char> raw_ascii_reader<Istream, StatsPolicy>::take_numstr(
+    JsonIstream& is, char(&buf)[N], basic_ostdsstream<>& scratch)
+{
+    return take_numstr(is, buf, N, scratch, iutil::has_input_window<JsonIstream>{});
 }
 
-template <typename Istream>
+template <typename Istream, typename StatsPolicy>
 template <typename FloatT>
-inline FloatT raw_ascii_reader<Istream>::read_floating(const char* type_label)
+inline FloatT raw_ascii_reader<Istream, StatsPolicy>::read_floating(const char* type_label)
 {
     std::size_t error_offset;
-    if (!iutil::skip_ws(m_stream, error_offset)) goto fail;
+    if (!skip_ws(error_offset)) goto fail;
 
     FloatT value;
     {
-        char strbuf[iutil::max_chars10<FloatT>::value];
-        unchecked_ostrspanstream numstream(strbuf, sizeof(strbuf));
-        take_numstr(m_stream, numstream);
+        char strbuf[NUMSTR_BUFSIZE];
+        auto numstr = take_numstr(m_stream, strbuf, m_scratch);
 
-        if (!read_floating_impl(numstream, value)) goto fail;
+        if (!internal::charconv::parse_floating(numstr.begin, numstr.end, value)) goto fail;
     }
+    if (StatsPolicy::enabled)
+        count_number(std::is_same<FloatT, float>::value ? number::TYPE_float : number::TYPE_double);
     return value;
 fail:
     throw iutil::parse_error_exp(error_offset, type_label);
 }
 
-template <typename Istream>
-inline bool raw_ascii_reader<Istream>::read_number_impl(JsonIstream& stream, number& out_value)
+template <typename Istream, typename StatsPolicy>
+inline bool raw_ascii_reader<Istream, StatsPolicy>::read_number_impl(
+    JsonIstream& stream, basic_ostdsstream<>& scratch, number& out_value)
 {
     auto out_inumber = [&](std::uintmax_t value, bool neg) -> bool 
     {
@@ -597,36 +888,26 @@ inline bool raw_ascii_reader<Istream>::read_number_impl(JsonIstream& stream, num
         else return { (float)value };
     };
 
-    char fpstrbuf[iutil::max_chars10<double>::value];
-    unchecked_ostrspanstream fpstream(fpstrbuf, sizeof(fpstrbuf)); // floating point value
+    char strbuf[NUMSTR_BUFSIZE];
+    auto numstr = take_numstr(stream, strbuf, scratch);
+    const char* p = numstr.begin;
+    const char* end = numstr.end;
 
-    bool neg = stream.peek() == '-';
-    if (neg) fpstream.put(stream.take());
+    bool neg = p != end && *p == '-';
+    if (neg) p++;
 
-    if (stream.end() || !iutil::is_digit(stream.peek()))
+    std::uintmax_t int_v;
+    if (!internal::charconv::parse_uint(p, end, int_v))
         return false;
-
-    std::uintmax_t old_int_v, int_v = 0;
-    while (!stream.end() && iutil::is_digit(stream.peek()))
-    {
-        old_int_v = int_v;
-        char c = stream.take(); fpstream.put(c);
-        int_v = 10 * int_v + (c - '0');
-        if (int_v < old_int_v) return false; // overflow
-    }
-    if (stream.end() || iutil::is_ws(stream.peek()))
+    if (p == end)
         return out_inumber(int_v, neg);
 
-    switch (stream.peek())
+    switch (*p)
     {
-        case ',': case']': case '}':
-            return out_inumber(int_v, neg);
-
         case '.': case 'e': case 'E':
         {
             double float_v;
-            take_numstr(stream, fpstream); // remaining
-            bool success = read_floating_impl<false>(fpstream, float_v);
+            bool success = internal::charconv::parse_floating(numstr.begin, numstr.end, float_v);
             if (success) out_value = to_fnumber(float_v);
             return success;
         }
@@ -635,24 +916,25 @@ inline bool raw_ascii_reader<Istream>::read_number_impl(JsonIstream& stream, num
     }
 }
 
-template <typename Istream>
-inline number raw_ascii_reader<Istream>::read_number(void)
+template <typename Istream, typename StatsPolicy>
+inline number raw_ascii_reader<Istream, StatsPolicy>::read_number(void)
 {
     number value; 
     std::size_t error_offset;
 
-    if (!iutil::skip_ws(m_stream, error_offset)) goto fail;
-    if (!read_number_impl(m_stream, value)) goto fail;
+    if (!skip_ws(error_offset)) goto fail;
+    if (!read_number_impl(m_stream, m_scratch, value)) goto fail;
+    if (StatsPolicy::enabled) count_number(value.type());
     return value;
 fail:
     throw iutil::parse_error_exp(error_offset, "number");
 }
 
-template <typename Istream>
-inline bool raw_ascii_reader<Istream>::read_bool(void)
+template <typename Istream, typename StatsPolicy>
+inline bool raw_ascii_reader<Istream, StatsPolicy>::read_bool(void)
 {
     std::size_t error_offset;
-    if (!iutil::skip_ws(m_stream, error_offset)) goto fail;
+    if (!skip_ws(error_offset)) goto fail;
 
     if (m_stream.peek() == 't')
     {
@@ -660,6 +942,7 @@ inline bool raw_ascii_reader<Istream>::read_bool(void)
         if (m_stream.end() || m_stream.take() != 'r') goto fail;
         if (m_stream.end() || m_stream.take() != 'u') goto fail;
         if (m_stream.end() || m_stream.take() != 'e') goto fail;
+        if (StatsPolicy::enabled) m_stats.count_token(TOKEN_boolean);
         return true;
     }
     else if (m_stream.peek() == 'f')
@@ -669,22 +952,24 @@ inline bool raw_ascii_reader<Istream>::read_bool(void)
         if (m_stream.end() || m_stream.take() != 'l') goto fail;
         if (m_stream.end() || m_stream.take() != 's') goto fail;
         if (m_stream.end() || m_stream.take() != 'e') goto fail;
+        if (StatsPolicy::enabled) m_stats.count_token(TOKEN_boolean);
         return false;
     }
 fail:
     throw iutil::parse_error_exp(error_offset, "bool");
 }
 
-template <typename Istream>
-inline void raw_ascii_reader<Istream>::read_null(void)
+template <typename Istream, typename StatsPolicy>
+inline void raw_ascii_reader<Istream, StatsPolicy>::read_null(void)
 {
     std::size_t error_offset;
-    if (!iutil::skip_ws(m_stream, error_offset)) goto fail;
+    if (!skip_ws(error_offset)) goto fail;
 
     if (m_stream.end() || m_stream.take() != 'n') goto fail;
     if (m_stream.end() || m_stream.take() != 'u') goto fail;
     if (m_stream.end() || m_stream.take() != 'l') goto fail;
     if (m_stream.end() || m_stream.take() != 'l') goto fail;
+    if (StatsPolicy::enabled) m_stats.count_token(TOKEN_null);
     return;
 fail:
     throw iutil::parse_error_exp(error_offset, "null");
@@ -697,7 +982,7 @@ class streq_ostream
 {
 public:
     streq_ostream(const char* str, IsEndpFunc is_endp) :
-        m_equal(true), m_strp(str), m_is_endp(is_endp)
+        m_equal(true), m_begin(str), m_strp(str), m_is_endp(is_endp)
     {}
 
     inline void put(char c)
@@ -711,20 +996,31 @@ public:
         else m_equal = false;
     }
 
+    inline void putn(const char* str, std::size_t count)
+    {
+        for (std::size_t i = 0; m_equal && i < count; ++i)
+            put(str[i]);
+    }
+
     inline bool str_is_equal(void) const noexcept
     {
         return m_equal && m_is_endp(m_strp);
     }
+
+    // Number of chars compared.
+    inline std::size_t outpos(void) const noexcept { return (std::size_t)(m_strp - m_begin); }
+
 private:
     bool m_equal;
+    const char* m_begin;
     const char* m_strp;
     IsEndpFunc m_is_endp;
 };
 }
 
-template <typename Istream>
+template <typename Istream, typename StatsPolicy>
 template <typename Ostream>
-inline void raw_ascii_reader<Istream>::take_unescape(JsonIstream& is, Ostream& os)
+inline void raw_ascii_reader<Istream, StatsPolicy>::take_unescape(JsonIstream& is, Ostream& os)
 {
     assert(!is.end());
     const char* EXSTR_bad_escape = "Invalid escape sequence.";
@@ -746,6 +1042,7 @@ inline void raw_ascii_reader<Istream>::take_unescape(JsonIstream& is, Ostream& o
             case 'r': os.put('\r'); break;
             case 't': os.put('\t'); break;
             case '"': os.put('"'); break;
+            case '\\': os.put('\\'); break;
             case '/': os.put('/'); break; // MS-only?
             default: 
                 throw iutil::parse_error(is.inpos() - 1, EXSTR_bad_escape);
@@ -753,16 +1050,206 @@ inline void raw_ascii_reader<Istream>::take_unescape(JsonIstream& is, Ostream& o
     }
 }
 
-template <typename Istream>
+template <typename Istream, typename StatsPolicy>
+template <bool Quoted, typename Ostream>
+inline void raw_ascii_reader<Istream, StatsPolicy>::take_unescape_all(JsonIstream& is, Ostream& os, std::false_type)
+{
+    while (!is.end() && (!Quoted || is.peek() != '"'))
+        take_unescape(is, os);
+}
+
+template <typename Istream, typename StatsPolicy>
+template <bool Quoted, typename Ostream>
+inline void raw_ascii_reader<Istream, StatsPolicy>::take_unescape_all(JsonIstream& is, Ostream& os, std::true_type)
+{
+    while (true)
+    {
+        auto window = is.window();
+        if (window.begin == window.end)
+            return;
+
+        // put runs of chars that need no unescaping at once
+        const char* next = internal::simd::find_first_of(
+            window.begin, window.end, Quoted ? '"' : '\\', '\\');
+        if (next != window.begin)
+        {
+            os.putn(window.begin, (std::size_t)(next - window.begin));
+            is.advance((std::size_t)(next - window.begin));
+        }
+        if (next == window.end)
+            continue;
+        if (*next == '"')
+            return;
+
+        take_unescape(is, os);
+    }
+}
+
+// Take and unescape chars until the end of the stream,
+// or if Quoted is true, until the closing quotes (not taken).
+template <typename Istream, typename StatsPolicy>
+template <bool Quoted, typename Ostream>
+inline void raw_ascii_reader<Istream, StatsPolicy>::take_unescape_all(JsonIstream& is, Ostream& os)
+{
+    take_unescape_all<Quoted>(is, os, iutil::has_input_window<JsonIstream>{});
+}
+
+// Take chars until the closing quotes (taken).
+// Returns false if the stream ends first.
+template <typename Istream, typename StatsPolicy>
+inline bool raw_ascii_reader<Istream, StatsPolicy>::skip_string_body(JsonIstream& is, std::false_type)
+{
+    while (!is.end())
+    {
+        char c = is.take();
+        if (c == '"')
+            return true;
+        if (c == '\\')
+        {
+            if (is.end()) break;
+            is.take();
+        }
+    }
+    return false;
+}
+
+template <typename Istream, typename StatsPolicy>
+inline bool raw_ascii_reader<Istream, StatsPolicy>::skip_string_body(JsonIstream& is, std::true_type)
+{
+    while (true)
+    {
+        auto window = is.window();
+        if (window.begin == window.end)
+            return false;
+
+        const char* p = window.begin;
+        while (true)
+        {
+            p = internal::simd::find_first_of(p, window.end, '"', '\\');
+            if (p == window.end || 
+                (*p == '\\' && window.end - p < 2))
+                break;
+            
+            if (*p == '"')
+            {
+                is.advance((std::size_t)(p + 1 - window.begin));
+                return true;
+            }
+            p += 2; // escape sequence
+        }
+        is.advance((std::size_t)(p - window.begin));
+
+        if (p != window.end)
+        {
+            // escape sequence crosses the window
+            is.take();
+            if (is.end()) return false;
+            is.take();
+        }
+    }
+}
+
+// Take chars until the bracket that closes an
+// already taken '{' or '[' (taken).
+// Returns false if the stream ends first.
+template <typename Istream, typename StatsPolicy>
+inline bool raw_ascii_reader<Istream, StatsPolicy>::skip_nested(JsonIstream& is, std::false_type)
+{
+    std::size_t depth = 1;
+    while (!is.end())
+    {
+        switch (is.take())
+        {
+            case '"': 
+                if (!skip_string_body(is, std::false_type{})) 
+                    return false;
+                break;
+            case '{': case '[': depth++; break;
+            case '}': case ']':
+                if (--depth == 0) 
+                    return true;
+                break;
+            default: break;
+        }
+    }
+    return false;
+}
+
+template <typename Istream, typename StatsPolicy>
+inline bool raw_ascii_reader<Istream, StatsPolicy>::skip_nested(JsonIstream& is, std::true_type)
+{
+    std::size_t depth = 1;
+    while (true)
+    {
+        auto window = is.window();
+        if (window.begin == window.end)
+            return false;
+
+        const char* p = window.begin;
+        for (; p != window.end; ++p)
+        {
+            char c = *p;
+            if (c == '"') break;
+            if (c == '{' || c == '[') depth++;
+            else if ((c == '}' || c == ']') && --depth == 0)
+            {
+                is.advance((std::size_t)(p + 1 - window.begin));
+                return true;
+            }
+        }
+        is.advance((std::size_t)(p - window.begin));
+        if (p == window.end)
+            continue;
+
+        is.take(); // open quotes
+        if (!skip_string_body(is, std::true_type{}))
+            return false;
+    }
+}
+
+template <typename Istream, typename StatsPolicy>
+inline void raw_ascii_reader<Istream, StatsPolicy>::skip_value(void)
+{
+    std::size_t error_offset;
+    if (!skip_ws(error_offset)) goto fail;
+    if (StatsPolicy::enabled) count_skipped(m_stream.peek());
+
+    switch (m_stream.peek())
+    {
+        case '"':
+            m_stream.take();
+            if (!skip_string_body(m_stream, iutil::has_input_window<JsonIstream>{})) goto fail;
+            return;
+
+        case '{': case '[':
+            m_stream.take();
+            if (!skip_nested(m_stream, iutil::has_input_window<JsonIstream>{})) goto fail;
+            return;
+
+        case 't': case 'f': case 'n': case '-':
+            break;
+
+        default:
+            if (!iutil::is_digit(m_stream.peek())) goto fail;
+            break;
+    }
+    // number, bool or null
+    while (!m_stream.end() && !is_numstr_end(m_stream.peek()))
+        m_stream.take();
+    return;
+fail:
+    throw iutil::parse_error_exp(error_offset, "value");
+}
+
+template <typename Istream, typename StatsPolicy>
 template <typename Ostream>
-inline void raw_ascii_reader<Istream>::read_string_impl(JsonIstream& is, Ostream& os)
+inline void raw_ascii_reader<Istream, StatsPolicy>::read_string_impl(JsonIstream& is, Ostream& os)
 {
     if (!iutil::skip_ws(is) || is.peek() != '"')
         goto fail;
 
     is.take(); // open quotes
-    while (!is.end() && is.peek() != '"')
-        take_unescape(is, os);
+    take_unescape_all<true>(is, os);
 
     if (is.end()) goto fail;
     is.take(); // close quotes
@@ -772,10 +1259,57 @@ fail:
     throw iutil::parse_error_exp(is.inpos(), "string");
 }
 
-template <typename Istream>
+template <typename Istream, typename StatsPolicy>
+inline string_view raw_ascii_reader<Istream, StatsPolicy>::read_string_view_impl(
+    JsonIstream& is, basic_ostdsstream<>& scratch, std::false_type)
+{
+    scratch.clear();
+    read_string_impl(is, scratch);
+
+    auto str = scratch.outdata();
+    return internal::make_string_view(str.begin, str.end);
+}
+
+template <typename Istream, typename StatsPolicy>
+inline string_view raw_ascii_reader<Istream, StatsPolicy>::read_string_view_impl(
+    JsonIstream& is, basic_ostdsstream<>& scratch, std::true_type)
+{
+    if (!iutil::skip_ws(is) || is.peek() != '"')
+        goto fail;
+    {
+        auto data = is.indata();
+        const char* begin = data.begin + is.inpos() + 1;
+        const char* next = internal::simd::find_first_of(begin, data.end, '"', '\\');
+        if (next == data.end)
+        {
+            is.advance((std::size_t)(data.end - begin) + 1);
+            goto fail;
+        }
+        if (*next == '"')
+        {
+            is.advance((std::size_t)(next - begin) + 2);
+            return internal::make_string_view(begin, next);
+        }
+        // unescape into scratch
+        scratch.clear();
+        scratch.putn(begin, (std::size_t)(next - begin));
+        is.advance((std::size_t)(next - begin) + 1);
+        take_unescape_all<true>(is, scratch);
+
+        if (is.end()) goto fail;
+        is.take(); // close quotes
+
+        auto str = scratch.outdata();
+        return internal::make_string_view(str.begin, str.end);
+    }
+fail:
+    throw iutil::parse_error_exp(is.inpos(), "string");
+}
+
+template <typename Istream, typename StatsPolicy>
 template <typename Func>
 inline bool
-raw_ascii_reader<Istream>::read_string_or_null_impl(JsonIstream& is, Func get_os)
+raw_ascii_reader<Istream, StatsPolicy>::read_string_or_null_impl(JsonIstream& is, Func get_os)
 {
     if (!iutil::skip_ws(is)) goto fail;
 
@@ -792,8 +1326,7 @@ raw_ascii_reader<Istream>::read_string_or_null_impl(JsonIstream& is, Func get_os
         auto&& os = get_os();
 
         is.take(); // open quotes
-        while (!is.end() && is.peek() != '"')
-            take_unescape(is, os);
+        take_unescape_all<true>(is, os);
 
         if (is.end()) goto fail;
         is.take(); // close quotes
@@ -804,22 +1337,58 @@ fail:
     throw iutil::parse_error_exp(is.inpos(), "string or null");
 }
 
-template <typename Istream>
+template <typename Istream, typename StatsPolicy>
 template <typename Ostream>
-inline void raw_ascii_reader<Istream>::read_string(Ostream& os, bool quoted)
+inline void raw_ascii_reader<Istream, StatsPolicy>::read_string(Ostream& os, bool quoted)
 {
+    skip_counted_ws();
+    std::size_t startpos = StatsPolicy::enabled ? os.outpos() : 0;
+
     if (quoted)
         read_string_impl(m_stream, os);
     else {
         // if none of this succeeds, string will just be empty
-        iutil::skip_ws(m_stream);
-        while (!m_stream.end())
-            take_unescape(m_stream, os);
+        skip_ws();
+        take_unescape_all<false>(m_stream, os);
+    }
+    if (StatsPolicy::enabled) count_string(os.outpos() - startpos);
+}
+
+template <typename Istream, typename StatsPolicy>
+template <typename Func>
+inline token_t raw_ascii_reader<Istream, StatsPolicy>::read_string_or_null(Func get_os, std::false_type)
+{
+    return read_string_or_null_impl(m_stream, get_os) ? TOKEN_string : TOKEN_null;
+}
+
+template <typename Istream, typename StatsPolicy>
+template <typename Func>
+inline token_t raw_ascii_reader<Istream, StatsPolicy>::read_string_or_null(Func get_os, std::true_type)
+{
+    if (!skip_ws() || m_stream.peek() != '"')
+    {   // null, or throws
+        read_string_or_null_impl(m_stream, get_os);
+        m_stats.count_token(TOKEN_null);
+        return TOKEN_null;
     }
+    // get_os() may return a proxy by value, keep it here
+    auto&& os = get_os();
+    std::size_t startpos = os.outpos();
+
+    read_string_or_null_impl(m_stream, [&]() -> decltype(os)& { return os; });
+    count_string(os.outpos() - startpos);
+    return TOKEN_string;
+}
+
+template <typename Istream, typename StatsPolicy>
+template <typename Func>
+inline token_t raw_ascii_reader<Istream, StatsPolicy>::read_string_or_null(Func get_os)
+{
+    return read_string_or_null(get_os, std::integral_constant<bool, StatsPolicy::enabled>{});
 }
 
-template <typename Istream, typename AllocatorPolicy>
-inline void ascii_reader<Istream, AllocatorPolicy>::read_separator(void)
+template <typename Istream, typename AllocatorPolicy, typename StatsPolicy>
+inline void ascii_reader<Istream, AllocatorPolicy, StatsPolicy>::read_separator(void)
 {
     if (this->m_nodes.top().has_children)
     {
@@ -836,9 +1405,9 @@ inline void ascii_reader<Istream, AllocatorPolicy>::read_separator(void)
         m_rr.read_key_separator();
 }
 
-template <typename Istream, typename AllocatorPolicy>
+template <typename Istream, typename AllocatorPolicy, typename StatsPolicy>
 template <typename Traits, typename Allocator>
-inline std::basic_string<char, Traits, Allocator> ascii_reader<Istream, AllocatorPolicy>::read_key(void)
+inline std::basic_string<char, Traits, Allocator> ascii_reader<Istream, AllocatorPolicy, StatsPolicy>::read_key(void)
 {
     this->template assert_rule<DOCNODE_key>();
 
@@ -850,27 +1419,34 @@ inline std::basic_string<char, Traits, Allocator> ascii_reader<Istream, Allocato
     return str;
 }
 
-template <typename Istream, typename AllocatorPolicy>
-template <typename Traits, typename IsEndpFunc>
-inline bool ascii_reader<Istream, AllocatorPolicy>::read_key_impl(const char* str, IsEndpFunc is_endp, std::size_t& out_pos)
+template <typename Istream, typename AllocatorPolicy, typename StatsPolicy>
+template <typename Ostream>
+inline void ascii_reader<Istream, AllocatorPolicy, StatsPolicy>::read_key_impl(Ostream& os, std::size_t& out_pos)
 {
     this->template assert_rule<DOCNODE_key>();
 
     read_separator();
+    m_rr.skip_counted_ws();
     iutil::skip_ws(m_rr.stream(), out_pos);
 
-    internal::streq_ostream<Traits, IsEndpFunc> os(str, is_endp);
     m_rr.read_string(os);
 
     this->m_nodes.push({ DOCNODE_key });
     // don't end_child_node(), key-value pair is incomplete
+}
 
+template <typename Istream, typename AllocatorPolicy, typename StatsPolicy>
+template <typename Traits, typename IsEndpFunc>
+inline bool ascii_reader<Istream, AllocatorPolicy, StatsPolicy>::read_key_impl(const char* str, IsEndpFunc is_endp, std::size_t& out_pos)
+{
+    internal::streq_ostream<Traits, IsEndpFunc> os(str, is_endp);
+    read_key_impl(os, out_pos);
     return os.str_is_equal();
 }
 
-template <typename Istream, typename AllocatorPolicy>
+template <typename Istream, typename AllocatorPolicy, typename StatsPolicy>
 template <typename Traits, typename Allocator>
-inline void ascii_reader<Istream, AllocatorPolicy>::read_key(const std::basic_string<char, Traits, Allocator>& expected_key)
+inline void ascii_reader<Istream, AllocatorPolicy, StatsPolicy>::read_key(const std::basic_string<char, Traits, Allocator>& expected_key)
 {
     auto is_endp = [&](const char* p) { return p == expected_key.data() + expected_key.size(); };
 
@@ -879,8 +1455,8 @@ inline void ascii_reader<Istream, AllocatorPolicy>::read_key(const std::basic_st
         throw iutil::parse_error_exp(startpos, "string \"" + std::string(expected_key.data(), expected_key.length()) + "\"");
 }
 
-template <typename Istream, typename AllocatorPolicy>
-inline void ascii_reader<Istream, AllocatorPolicy>::read_key(const char* expected_key)
+template <typename Istream, typename AllocatorPolicy, typename StatsPolicy>
+inline void ascii_reader<Istream, AllocatorPolicy, StatsPolicy>::read_key(const char* expected_key)
 {
     auto is_endp = [](const char* p) { return *p == '\0'; };
 
@@ -889,8 +1465,8 @@ inline void ascii_reader<Istream, AllocatorPolicy>::read_key(const char* expecte
         throw iutil::parse_error_exp(startpos, "string \"" + std::string(expected_key) + "\"");
 }
 
-template <typename Istream, typename AllocatorPolicy>
-inline void ascii_reader<Istream, AllocatorPolicy>::read_key(const char* expected_key, std::size_t length)
+template <typename Istream, typename AllocatorPolicy, typename StatsPolicy>
+inline void ascii_reader<Istream, AllocatorPolicy, StatsPolicy>::read_key(const char* expected_key, std::size_t length)
 {
     auto is_endp = [&](const char* p) { return p == expected_key + length; };
 
@@ -899,9 +1475,9 @@ inline void ascii_reader<Istream, AllocatorPolicy>::read_key(const char* expecte
         throw iutil::parse_error_exp(startpos, "string \"" + std::string(expected_key, length) + "\"");
 }
 
-template <typename Istream, typename AllocatorPolicy>
+template <typename Istream, typename AllocatorPolicy, typename StatsPolicy>
 template <typename Value>
-inline Value ascii_reader<Istream, AllocatorPolicy>::read_value(void)
+inline Value ascii_reader<Istream, AllocatorPolicy, StatsPolicy>::read_value(void)
 {
     this->template assert_rule<DOCNODE_value>();
 
@@ -912,9 +1488,9 @@ inline Value ascii_reader<Istream, AllocatorPolicy>::read_value(void)
     return value;
 }
 
-template <typename Istream, typename AllocatorPolicy>
+template <typename Istream, typename AllocatorPolicy, typename StatsPolicy>
 template <typename Key, typename Value>
-inline std::pair<Key, Value> ascii_reader<Istream, AllocatorPolicy>::read_key_value(void)
+inline std::pair<Key, Value> ascii_reader<Istream, AllocatorPolicy, StatsPolicy>::read_key_value(void)
 {
     static_assert(iutil::is_instance_of_basic_string<Key, char>::value, 
         "Key must be a std::basic_string with value_type char.");
@@ -0,0 +1,127 @@
+//
+// Parse statistics.
+//
+
+#ifndef SIJSON_STATS_HPP
+#define SIJSON_STATS_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "internal/util.hpp"
+
+#include "common.hpp"
+#include "number.hpp"
+
+
+namespace sijson {
+
+// Counters collected by readers with collect_stats.
+struct parse_stats
+{
+    // Number of tokens read, indexed by token_t.
+    // A value skipped with skip_value() counts as one token.
+    std::size_t tokens[NUM_TOKEN_TYPES];
+
+    // Number of whitespace chars skipped before tokens.
+    std::size_t whitespace_bytes;
+
+    // Length of strings read (including keys), after unescaping.
+    std::size_t string_bytes;
+
+    // Number of numbers read, indexed by number::type_t.
+    // Integers are counted as TYPE_intmax_t or TYPE_uintmax_t.
+    std::size_t numbers[number::TYPE_uintmax_t + 1];
+
+    // Maximum nesting depth of the objects and arrays read.
+    std::size_t max_depth;
+
+    // Number of times the stream refilled its buffer,
+    // if it counts them (e.g. ifilestream). Otherwise 0.
+    std::size_t refills;
+};
+
+
+// Stats policy that collects nothing. Has no overhead.
+struct no_stats
+{
+    static constexpr bool enabled = false;
+
+    // Skip whitespace before a token.
+    // Returns true if stream has more characters.
+    template <typename Istream>
+    inline bool skip_ws(Istream& is) { return iutil::skip_ws(is); }
+
+    inline void count_token(token_t) noexcept {}
+    inline void count_string(std::size_t) noexcept {}
+    inline void count_number(number::type_t) noexcept {}
+    inline void start_node(void) noexcept {}
+    inline void end_node(void) noexcept {}
+};
+
+// Stats policy that collects parse_stats.
+class collect_stats
+{
+public:
+    static constexpr bool enabled = true;
+
+    collect_stats(void) noexcept : m_stats(), m_depth(0) {}
+
+    // Skip whitespace before a token.
+    // Returns true if stream has more characters.
+    template <typename Istream>
+    inline bool skip_ws(Istream& is)
+    {
+        std::size_t pos = is.inpos();
+        bool rval = iutil::skip_ws(is);
+        m_stats.whitespace_bytes += is.inpos() - pos;
+        return rval;
+    }
+
+    inline void count_token(token_t token) noexcept { m_stats.tokens[token]++; }
+    inline void count_string(std::size_t length) noexcept { m_stats.string_bytes += length; }
+    inline void count_number(number::type_t type) noexcept { m_stats.numbers[type]++; }
+
+    inline void start_node(void) noexcept
+    {
+        m_depth++;
+        if (m_depth > m_stats.max_depth)
+            m_stats.max_depth = m_depth;
+    }
+
+    inline void end_node(void) noexcept
+    {
+        if (m_depth != 0)
+            m_depth--;
+    }
+
+    // Counters collected so far. refills is not set.
+    inline const parse_stats& stats(void) const noexcept { return m_stats; }
+
+private:
+    parse_stats m_stats;
+    std::size_t m_depth;
+};
+
+
+namespace internal {
+
+template <typename T, typename = void>
+struct has_refill_count : std::false_type {};
+
+template <typename T>
+struct has_refill_count<T, iutil::void_t<
+    decltype(std::declval<const T>().num_refills())>> : std::true_type
+{};
+
+template <typename Istream>
+inline std::size_t refill_count(const Istream& is, std::true_type) { return is.num_refills(); }
+
+template <typename Istream>
+inline std::size_t refill_count(const Istream&, std::false_type) { return 0; }
+
+}
+}
+
+#endif
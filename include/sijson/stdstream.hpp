@@ -6,15 +6,42 @@
 #include <type_traits>
 #include <limits>
 #include <iostream>
+#include <streambuf>
 #include <iterator>
 #include <algorithm>
 #include <stdexcept>
 
+#include "common.hpp"
 #include "internal/util.hpp"
 
 
 namespace sijson {
 
+namespace internal
+{
+// Access to the get area of a std::basic_streambuf.
+// Pointers to the protected members are formed through this
+// class, which is allowed, and applied to the streambuf.
+template <typename CharT, typename Traits>
+class streambuf_get_area : std::basic_streambuf<CharT, Traits>
+{
+private:
+    using base = std::basic_streambuf<CharT, Traits>;
+
+public:
+    static inline CharT* begin(base& sb) { return (sb.*&streambuf_get_area::gptr)(); }
+    static inline CharT* end(base& sb) { return (sb.*&streambuf_get_area::egptr)(); }
+
+    static inline void advance(base& sb, std::size_t count)
+    {
+        constexpr std::size_t max_bump = (std::size_t)std::numeric_limits<int>::max();
+        for (; count > max_bump; count -= max_bump)
+            (sb.*&streambuf_get_area::gbump)((int)max_bump);
+        (sb.*&streambuf_get_area::gbump)((int)count);
+    }
+};
+}
+
 // Adapts a std::basic_istream to this library's istream.
 template <typename BasicIstream = std::istream>
 class std_istream_wrapper
@@ -27,9 +54,12 @@ public:
     using traits_type = typename BasicIstream::traits_type;
     using wrapped_type = BasicIstream;
 
+private:
+    using get_area = internal::streambuf_get_area<char, traits_type>;
+
 public:
     std_istream_wrapper(BasicIstream& stream) :
-        m_stream(stream)
+        m_stream(stream), m_posn(0), m_char('\0')
     {}
 
     std_istream_wrapper(std_istream_wrapper&&) = default;
@@ -43,23 +73,67 @@ public:
     inline char peek(void) { return traits_type::to_char_type(m_stream.peek()); }
 
     // Extract character. If end(), behavior is undefined.
-    inline char take(void) { return traits_type::to_char_type(m_stream.get()); }
+    inline char take(void)
+    {
+        m_posn++;
+        return traits_type::to_char_type(m_stream.get());
+    }
 
-    // Get input position.
-    inline std::size_t inpos(void) { return m_stream.tellg(); }
+    // Extract count characters. count must
+    // not be larger than window().size().
+    inline void advance(std::size_t count)
+    {
+        auto& sb = *m_stream.rdbuf();
+        if (get_area::begin(sb) != get_area::end(sb))
+            get_area::advance(sb, count);
+        else if (count != 0)
+            sb.sbumpc(); // unbuffered, see window()
 
-    // True if the last operation completed by reaching the end of the stream.
-    inline bool end(void) const { return m_stream.eof(); }
+        m_posn += count;
+    }
+
+    // Span of the chars buffered by the stream from inpos().
+    // Empty only if end(). If the stream is unbuffered, the span
+    // has one char and is invalidated by advance().
+    inline memspan<const char> window(void)
+    {
+        auto sb = m_stream.rdbuf();
+        if (!sb || !m_stream.good() ||
+            traits_type::eq_int_type(sb->sgetc(), traits_type::eof()))
+            return { nullptr, nullptr };
+
+        if (get_area::begin(*sb) == get_area::end(*sb))
+        {
+            m_char = traits_type::to_char_type(sb->sgetc());
+            return { &m_char, &m_char + 1 };
+        }
+        return { get_area::begin(*sb), get_area::end(*sb) };
+    }
+
+    // Get input position (num characters taken).
+    inline std::size_t inpos(void) const noexcept { return m_posn; }
+
+    // True if there are no more chars to extract.
+    inline bool end(void) const 
+    { 
+        return traits_type::eq_int_type(m_stream.peek(), traits_type::eof());
+    }
 
     // Jump to the beginning of the stream.
-    inline void rewind(void) { m_stream.seekg(0, std::ios_base::beg); }
+    inline void rewind(void) 
+    { 
+        m_stream.seekg(0, std::ios_base::beg);
+        m_posn = 0;
+    }
 
 private:
     BasicIstream& m_stream;
+    std::size_t m_posn;
+    // Window of unbuffered stream.
+    char m_char;
 };
 
 
-
 // Adapts a std::basic_ostream to this library's ostream.
 template <typename BasicOstream = std::ostream>
 class std_ostream_wrapper
@@ -186,6 +186,22 @@ public:
         m_buf.commit(count);
     }
 
+    // Get space for at least count chars at outpos().
+    // See is_oreservable.
+    inline char* reserve(std::size_t count)
+    {
+        m_buf.reserve(m_buf.length() + count);
+        return m_buf.end() - is_null_terminated;
+    }
+
+    // Output count chars from the space returned by reserve().
+    inline void commit(std::size_t count) noexcept
+    {
+        if (is_null_terminated)
+            Traits::assign(m_buf[m_buf.length() + count - 1], '\0');
+        m_buf.commit(count);
+    }
+
     // Synchronize with target.
     inline void flush(void) {}
 
@@ -248,13 +264,13 @@ public:
     basic_ostdsstream(std::size_t init_capacity,
         const Allocator& alloc = Allocator()
     ) :
-        m_str{ alloc }
+        m_str{ alloc }, m_reserved(0)
     {
         m_str.reserve(init_capacity);
     }
 
     basic_ostdsstream(const Allocator& alloc = Allocator()) :
-        m_str{ alloc }
+        m_str{ alloc }, m_reserved(0)
     {}
 
     basic_ostdsstream(basic_ostdsstream&&) = default;
@@ -278,12 +294,32 @@ public:
     // has no effect (strong exception guarantee).
     inline void putn(const char* str, std::size_t count) { m_str.append(str, count); }
 
+    // Get space for at least count chars at outpos().
+    // See is_oreservable.
+    inline char* reserve(std::size_t count)
+    {
+        std::size_t length = m_str.length();
+        m_str.resize(length + count);
+        m_reserved = count;
+        return &m_str[length];
+    }
+
+    // Output count chars from the space returned by reserve().
+    inline void commit(std::size_t count) noexcept
+    {
+        m_str.resize(m_str.length() - m_reserved + count);
+        m_reserved = 0;
+    }
+
     // Synchronize with target.
     inline void flush(void) {};
 
     // Get output position.
     inline std::size_t outpos(void) const noexcept { return m_str.length(); }
 
+    // Clear contents. Keeps capacity.
+    inline void clear(void) noexcept { m_str.clear(); }
+
     // Span of the underlying storage from 0 to outpos().
     // Span may be invalidated if a non-const reference to
     // the stream is passed to a function or if any non-const
@@ -318,6 +354,8 @@ public:
 
 private:
     string_type m_str;
+    // Chars reserved but not yet committed.
+    std::size_t m_reserved;
 };
 
 
@@ -403,6 +441,25 @@ public:
         m_cur += count;
     }
 
+    // Get space for at least count chars at outpos().
+    // If avail() < count, behavior is undefined
+    // unless ThrowOnOverflow is true.
+    // See is_oreservable.
+    inline char* reserve(std::size_t count)
+        noexcept(!ThrowOnOverflow)
+    {
+        check_avail(count);
+        return m_cur;
+    }
+
+    // Output count chars from the space returned by reserve().
+    inline void commit(std::size_t count) noexcept
+    {
+        if (is_null_terminated)
+            Traits::assign(m_cur[count], '\0');
+        m_cur += count;
+    }
+
     // Synchronize with target.
     inline void flush(void) {}
 
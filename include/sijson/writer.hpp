@@ -4,21 +4,25 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <cassert>
 #include <cmath>
 #include <limits>
+#include <algorithm>
 #include <ios>
 #include <ostream>
-#include <locale>
 #include <string>
 #include <utility>
+#include <type_traits>
 #include <stdexcept>
 
 #include "internal/util.hpp"
 #include "internal/buffers.hpp"
 #include "internal/impl_rw.hpp"
+#include "internal/impl_charconv.hpp"
 
 #include "common.hpp"
+#include "concepts.hpp"
 #include "number.hpp"
 #include "stringstream.hpp"
 #include "stdstream.hpp"
@@ -78,10 +82,7 @@ public:
     inline void write_string(const char* value)
     {
         if (value)
-        {
-            icsstream is(value);
-            write_string_from(is);
-        }
+            write_string_impl(value, std::strlen(value), is_oreservable<JsonOstream>{});
         else write_null();
     }
 
@@ -89,10 +90,7 @@ public:
     inline void write_string(const char* value, std::size_t length)
     {
         if (value)
-        {
-            isstream is(value, length);
-            write_string_from(is);
-        }
+            write_string_impl(value, length, is_oreservable<JsonOstream>{});
         else write_null();
     }
 
@@ -100,8 +98,7 @@ public:
     template <typename ...Ts>
     inline void write_string(const std::basic_string<char, Ts...>& value)
     {
-        isstream is(value.c_str(), value.length());
-        write_string_from(is);
+        write_string_impl(value.c_str(), value.length(), is_oreservable<JsonOstream>{});
     }
 
     // Write value of type T.
@@ -131,6 +128,52 @@ public:
     }
 
 private:
+    // Char that follows the backslash if c must
+    // be escaped, otherwise '\0'.
+    static inline char escape_char(char c) noexcept
+    {
+        switch (c)
+        {
+            case '\b': return 'b';
+            case '\f': return 'f';
+            case '\n': return 'n';
+            case '\r': return 'r';
+            case '\t': return 't';
+            case '"':  return '"';
+            case '\\': return '\\';
+            default: return '\0';
+        }
+    }
+
+    inline void write_string_impl(const char* str, std::size_t length, std::false_type)
+    {
+        isstream is(str, length);
+        write_string_from(is);
+    }
+
+    inline void write_string_impl(const char* str, std::size_t length, std::true_type);
+
+    // Write the result of format(char* buf), which writes at
+    // most max_chars into buf and returns the end of the result.
+    template <std::size_t max_chars, typename Func>
+    static inline void write_formatted(JsonOstream& stream, Func format, std::false_type)
+    {
+        char strbuf[max_chars];
+        char* strend = format(strbuf);
+        stream.putn(strbuf, (std::size_t)(strend - strbuf));
+    }
+
+    template <std::size_t max_chars, typename Func>
+    static inline void write_formatted(JsonOstream& stream, Func format, std::true_type)
+    {
+        // fixed-size streams may not fit max_chars
+        if (!iutil::can_reserve(stream, max_chars))
+            return write_formatted<max_chars>(stream, format, std::false_type{});
+
+        char* buf = stream.reserve(max_chars);
+        stream.commit((std::size_t)(format(buf) - buf));
+    }
+
     template <typename UintT>
     static inline void write_uint_impl(JsonOstream& stream, UintT value);
     template <typename IntT>
@@ -167,12 +210,19 @@ private:
 // ASCII JSON writer.
 template <typename Ostream, 
     // Allocator type used for internal purposes/book-keeping.
-    typename AllocatorPolicy = std::allocator<void>>
+    typename AllocatorPolicy = std::allocator<void>,
+    // If false, the document structure is not validated.
+    // Separators are still inserted automatically.
+    // See unchecked_ascii_writer.
+    bool Checked = true>
 class ascii_writer : public internal::rw_base<AllocatorPolicy>
 {
+private:
+    using checked = std::integral_constant<bool, Checked>;
+
 public:
     ascii_writer(Ostream& stream) :
-        m_rw{ stream }
+        m_rw{ stream }, m_need_separator(false)
     {
         this->m_nodes.push({ DOCNODE_root });
     }
@@ -181,50 +231,51 @@ public:
     // For eg. if you call start_object(), parent_node()
     // returns DOCNODE_object until the next call to 
     // end_object() or start_array().
-    inline doc_node_t parent_node(void) const { return this->m_nodes.top().type; }
+    // Not available if the writer is unchecked.
+    inline doc_node_t parent_node(void) const
+    {
+        static_assert(Checked, "Unchecked writer does not track nodes.");
+        return this->m_nodes.top().type;
+    }
 
     // Start writing object.
     inline void start_object(void)
     {
-        this->template start_node<DOCNODE_object>([&] {
-            write_separator();
-            m_rw.write_start_object();
-        });
+        start_node_impl<DOCNODE_object>(
+            [&] { m_rw.write_start_object(); }, checked{});
     }
 
     // Start writing array.
     inline void start_array(void)
     {
-        this->template start_node<DOCNODE_array>([&] {
-            write_separator();
-            m_rw.write_start_array();
-        });
+        start_node_impl<DOCNODE_array>(
+            [&] { m_rw.write_start_array(); }, checked{});
     }
 
     // End writing object.
     inline void end_object(void)
     {
-        this->template end_node<DOCNODE_object>([&] 
-        { m_rw.write_end_object(); });
+        end_node_impl<DOCNODE_object>(
+            [&] { m_rw.write_end_object(); }, checked{});
     }
 
     // End writing array.
     inline void end_array(void)
     {
-        this->template end_node<DOCNODE_array>([&] 
-        { m_rw.write_end_array(); });
+        end_node_impl<DOCNODE_array>(
+            [&] { m_rw.write_end_array(); }, checked{});
     }
 
     // Write object key.
     inline void write_key(const char* key)
     {
-        write_key_impl([&] { m_rw.write_string(key); }, !key);
+        write_key_impl([&] { m_rw.write_string(key); }, !key, checked{});
     }
 
     // Write object key.
     inline void write_key(const char* key, std::size_t length)
     {
-        write_key_impl([&] { m_rw.write_string(key, length); }, !key);
+        write_key_impl([&] { m_rw.write_string(key, length); }, !key, checked{});
     }
 
     // Write object key.
@@ -238,7 +289,7 @@ public:
     template <typename Value>
     inline void write_value(const Value& value)
     {
-        write_value_impl<iutil::decay_array_to_constptr_t<Value>>(value);
+        write_value_impl<iutil::decay_array_to_constptr_t<Value>>(value, checked{});
     }
 
     // Write object key-value pair.
@@ -246,7 +297,7 @@ public:
     inline void write_key_value(const char* key, const Value& value)
     {
         write_key_value_impl<iutil::decay_array_to_constptr_t<Value>>(
-            [&] { m_rw.write_string(key); }, !key, value);
+            [&] { m_rw.write_string(key); }, !key, value, checked{});
     }
 
     // Write object key-value pair.
@@ -254,7 +305,7 @@ public:
     inline void write_key_value(const char* key, std::size_t key_length, const Value& value)
     {
         write_key_value_impl<iutil::decay_array_to_constptr_t<Value>>(
-            [&] { m_rw.write_string(key, key_length); }, !key, value);
+            [&] { m_rw.write_string(key, key_length); }, !key, value, checked{});
     }
 
     // Write object key-value pair.
@@ -287,57 +338,94 @@ public:
 private:
     inline void write_separator(void);
 
+    // Unchecked writer only.
+    inline void write_item_separator_if_needed(void)
+    {
+        if (m_need_separator)
+            m_rw.write_item_separator();
+    }
+
+    template <doc_node_t type, typename Func>
+    inline void start_node_impl(Func do_write, std::true_type)
+    {
+        this->template start_node<type>([&] {
+            write_separator();
+            do_write();
+        });
+    }
+
+    template <doc_node_t type, typename Func>
+    inline void start_node_impl(Func do_write, std::false_type)
+    {
+        write_item_separator_if_needed();
+        do_write();
+        m_need_separator = false;
+    }
+
+    template <doc_node_t type, typename Func>
+    inline void end_node_impl(Func do_write, std::true_type)
+    {
+        this->template end_node<type>(do_write);
+    }
+
+    template <doc_node_t type, typename Func>
+    inline void end_node_impl(Func do_write, std::false_type)
+    {
+        do_write();
+        m_need_separator = true;
+    }
+
     template <typename Func>
-    inline void write_key_impl(Func do_write, bool is_null);
+    inline void write_key_impl(Func do_write, bool is_null, std::true_type);
+    template <typename Func>
+    inline void write_key_impl(Func do_write, bool is_null, std::false_type);
 
     template <typename Value>
-    inline void write_value_impl(const Value& value);
+    inline void write_value_impl(const Value& value, std::true_type);
+    template <typename Value>
+    inline void write_value_impl(const Value& value, std::false_type);
 
     template <typename Value, typename Func>
-    inline void write_key_value_impl(Func do_write_key, bool is_key_null, const Value& value);
+    inline void write_key_value_impl(Func do_write_key, bool is_key_null, const Value& value, std::true_type);
+    template <typename Value, typename Func>
+    inline void write_key_value_impl(Func do_write_key, bool is_key_null, const Value& value, std::false_type);
 
 private:
     raw_ascii_writer<Ostream> m_rw;
+    // Unchecked writer only. True if the next
+    // key or value must be preceded by a comma.
+    bool m_need_separator;
 };
 
 
+// ASCII JSON writer that does not validate the document structure.
+// Commas and colons are inserted automatically, but writing invalid
+// JSON (e.g. a value in an object without a key) is not detected.
+// Use when the sequence of calls is known to be valid
+// (e.g. generated serializers).
+template <typename Ostream, 
+    // Allocator type used for internal purposes/book-keeping.
+    typename AllocatorPolicy = std::allocator<void>>
+using unchecked_ascii_writer = ascii_writer<Ostream, AllocatorPolicy, false>;
+
+
 
 template <typename Ostream>
 template <typename UintT>
 inline void raw_ascii_writer<Ostream>::write_uint_impl(JsonOstream& stream, UintT value)
 {
-    char strbuf[iutil::max_chars10<UintT>::value];
-    const auto strbuf_end = strbuf + sizeof(strbuf);
-
-    auto strp = strbuf_end;
-    do {
-        // units first
-        *(--strp) = '0' + (char)(value % 10);
-        value /= 10;
-    } while (value != 0);
-
-    stream.putn(strp, strbuf_end - strp);
+    write_formatted<iutil::max_chars10<UintT>::value>(stream, [&](char* buf) {
+        return internal::charconv::format_uint(buf, value);
+    }, is_oreservable<JsonOstream>{});
 }
 
 template <typename Ostream>
 template <typename IntT>
 inline void raw_ascii_writer<Ostream>::write_int_impl(JsonOstream& stream, IntT value)
 {
-    char strbuf[iutil::max_chars10<IntT>::value];
-    const auto strbuf_end = strbuf + sizeof(strbuf);
-
-    auto abs_value = iutil::absu(value);
-    auto strp = strbuf_end;
-    do {
-        // units first
-        *(--strp) = '0' + (char)(abs_value % 10);
-        abs_value /= 10;
-    } while (abs_value != 0);
-
-    if (value < 0)
-        *(--strp) = '-';
-
-    stream.putn(strp, strbuf_end - strp);
+    write_formatted<iutil::max_chars10<IntT>::value>(stream, [&](char* buf) {
+        return internal::charconv::format_int(buf, value);
+    }, is_oreservable<JsonOstream>{});
 }
 
 template <typename Ostream>
@@ -347,16 +435,11 @@ inline void raw_ascii_writer<Ostream>::write_floating_impl(JsonOstream& stream,
     if (!std::isfinite(value))
         throw std::invalid_argument("Value is NAN or infinity.");
 
-    char strbuf[iutil::max_chars10<FloatT>::value];
-    internal::memspanbuf streambuf(strbuf, std::ios_base::out);
+    namespace charconv = internal::charconv;
 
-    std::ostream sstream(&streambuf);
-    sstream.imbue(std::locale::classic()); // make decimal point '.'
-    sstream.precision(std::numeric_limits<FloatT>::max_digits10);
-    sstream << value;
-
-    auto strdata = streambuf.data();
-    stream.putn(strdata.begin, strdata.size());
+    write_formatted<charconv::format_floating_max_chars<FloatT>::value>(stream, [&](char* buf) {
+        return charconv::format_floating(buf, value);
+    }, is_oreservable<JsonOstream>{});
 }
 
 template <typename Ostream>
@@ -390,25 +473,67 @@ inline void raw_ascii_writer<Ostream>::write_string_from(Istream& is, bool quote
     while (!is.end())
     {
         char c = is.take();
-        switch (c)
+        char esc = escape_char(c);
+        if (esc)
         {
-            case '\b': m_stream.putn("\\b", 2); break;
-            case '\f': m_stream.putn("\\f", 2); break;
-            case '\n': m_stream.putn("\\n", 2); break;
-            case '\r': m_stream.putn("\\r", 2); break;
-            case '\t': m_stream.putn("\\t", 2); break;
-            case '"':  m_stream.putn("\\\"", 2); break;
-            case '\\': m_stream.putn("\\\\", 2); break;
-
-            default: m_stream.put(c); break;
+            m_stream.put('\\');
+            m_stream.put(esc);
         }
+        else m_stream.put(c);
     }
     if (quoted)
         m_stream.put('"');
 }
 
-template <typename Ostream, typename AllocatorPolicy>
-inline void ascii_writer<Ostream, AllocatorPolicy>::write_separator(void)
+template <typename Ostream>
+inline void raw_ascii_writer<Ostream>::write_string_impl(
+    const char* str, std::size_t length, std::true_type)
+{
+    // escape in chunks, each char takes at most 2 chars
+    constexpr std::size_t CHUNK_SIZE = 256;
+
+    const char* first = str;
+    const char* last = str + length;
+    do
+    {
+        std::size_t n = std::min(CHUNK_SIZE, (std::size_t)(last - str));
+        // fixed-size streams may not fit the worst case,
+        // write the rest char by char
+        if (!iutil::can_reserve(m_stream, 2 * n + 2))
+        {
+            isstream is(str, (std::size_t)(last - str));
+            write_string_from(is, str == first);
+            if (str != first)
+                m_stream.put('"');
+            return;
+        }
+        // with room for quotes
+        char* out = m_stream.reserve(2 * n + 2);
+        char* out_begin = out;
+
+        if (str == first)
+            *out++ = '"';
+
+        for (const char* chunk_end = str + n; str != chunk_end; ++str)
+        {
+            char esc = escape_char(*str);
+            if (esc)
+            {
+                *out++ = '\\';
+                *out++ = esc;
+            }
+            else *out++ = *str;
+        }
+        if (str == last)
+            *out++ = '"';
+
+        m_stream.commit((std::size_t)(out - out_begin));
+    } 
+    while (str != last);
+}
+
+template <typename Ostream, typename AllocatorPolicy, bool Checked>
+inline void ascii_writer<Ostream, AllocatorPolicy, Checked>::write_separator(void)
 {
     if (this->m_nodes.top().has_children)
     {
@@ -425,9 +550,10 @@ inline void ascii_writer<Ostream, AllocatorPolicy>::write_separator(void)
         m_rw.write_key_separator();
 }
 
-template <typename Ostream, typename AllocatorPolicy>
+template <typename Ostream, typename AllocatorPolicy, bool Checked>
 template <typename Func>
-inline void ascii_writer<Ostream, AllocatorPolicy>::write_key_impl(Func do_write, bool is_null)
+inline void ascii_writer<Ostream, AllocatorPolicy, Checked>::write_key_impl(
+    Func do_write, bool is_null, std::true_type)
 {
     if (is_null) 
         throw std::invalid_argument("Key is null.");
@@ -441,9 +567,25 @@ inline void ascii_writer<Ostream, AllocatorPolicy>::write_key_impl(Func do_write
     // don't end_child_node(), key-value pair is incomplete
 }
 
-template <typename Ostream, typename AllocatorPolicy>
+template <typename Ostream, typename AllocatorPolicy, bool Checked>
+template <typename Func>
+inline void ascii_writer<Ostream, AllocatorPolicy, Checked>::write_key_impl(
+    Func do_write, bool is_null, std::false_type)
+{
+    if (is_null) 
+        throw std::invalid_argument("Key is null.");
+
+    write_item_separator_if_needed();
+    do_write();
+    m_rw.write_key_separator();
+
+    m_need_separator = false;
+}
+
+template <typename Ostream, typename AllocatorPolicy, bool Checked>
 template <typename Value>
-inline void ascii_writer<Ostream, AllocatorPolicy>::write_value_impl(const Value& value)
+inline void ascii_writer<Ostream, AllocatorPolicy, Checked>::write_value_impl(
+    const Value& value, std::true_type)
 {
     this->template assert_rule<DOCNODE_value>();
 
@@ -453,10 +595,21 @@ inline void ascii_writer<Ostream, AllocatorPolicy>::write_value_impl(const Value
     this->end_child_node();
 }
 
-template <typename Ostream, typename AllocatorPolicy>
+template <typename Ostream, typename AllocatorPolicy, bool Checked>
+template <typename Value>
+inline void ascii_writer<Ostream, AllocatorPolicy, Checked>::write_value_impl(
+    const Value& value, std::false_type)
+{
+    write_item_separator_if_needed();
+    m_rw.write(value);
+
+    m_need_separator = true;
+}
+
+template <typename Ostream, typename AllocatorPolicy, bool Checked>
 template <typename Value, typename Func>
-inline void ascii_writer<Ostream, AllocatorPolicy>::write_key_value_impl(
-    Func do_write_key, bool is_key_null, const Value& value)
+inline void ascii_writer<Ostream, AllocatorPolicy, Checked>::write_key_value_impl(
+    Func do_write_key, bool is_key_null, const Value& value, std::true_type)
 {
     if (is_key_null) 
         throw std::invalid_argument("Key is null.");
@@ -472,5 +625,21 @@ inline void ascii_writer<Ostream, AllocatorPolicy>::write_key_value_impl(
 
     this->end_child_node();
 }
+
+template <typename Ostream, typename AllocatorPolicy, bool Checked>
+template <typename Value, typename Func>
+inline void ascii_writer<Ostream, AllocatorPolicy, Checked>::write_key_value_impl(
+    Func do_write_key, bool is_key_null, const Value& value, std::false_type)
+{
+    if (is_key_null) 
+        throw std::invalid_argument("Key is null.");
+
+    write_item_separator_if_needed();
+    do_write_key();
+    m_rw.write_key_separator();
+    m_rw.write(value);
+
+    m_need_separator = true;
+}
 }
 #endif